@@ -15,6 +15,8 @@ void doMisses();
 
 void testSingle();
 void testParallel();
+void testParallelPersistent();
+void testRegions();
 void testParallelExhaustive();
 
 int main()
@@ -23,11 +25,18 @@ int main()
     testSingle();
     std::cout << "==========================> Example Parallel <===========================" << std::endl;
     testParallel();
+    std::cout << "==========================> Example Parallel Persistent <===========================" << std::endl;
+    testParallelPersistent();
+    std::cout << "==========================> Example Regions <===========================" << std::endl;
+    testRegions();
 }
 
 void testSingle()
 {
     PAPIW::INIT_SINGLE(PAPI_L2_TCA, PAPI_L1_TCM, PAPI_L3_TCA, PAPI_L3_TCM);
+    /* L3 misses are not available on every machine, e.g. in virtual machines */
+    if (PAPIW::IS_COUNTED(PAPI_L3_TCM))
+        PAPIW::SAMPLE(PAPI_L3_TCM, 100000);
 
     std::cout << "==========================> Do Flops <===========================" << std::endl;
     PAPIW::START();
@@ -50,6 +59,7 @@ void testSingle()
     doMisses();
     PAPIW::STOP();
     PAPIW::PRINT();
+    PAPIW::PRINT_SAMPLES();
 }
 
 void testParallel()
@@ -66,6 +76,7 @@ void testParallel()
 
     std::cout << "==========================> Do Reads <===========================" << std::endl;
     PAPIW::PRINT();
+    PAPIW::PRINT_THREADS();
 
     PAPIW::RESET();
 
@@ -80,6 +91,66 @@ void testParallel()
     PAPIW::PRINT();
 }
 
+void testParallelPersistent()
+{
+    PAPIW::INIT_PARALLEL_PERSISTENT(PAPI_L2_TCA, PAPI_L1_TCM, PAPI_L3_TCA, PAPI_L3_TCM);
+
+    /* Additionally, the running counters of every thread are written to a file every 100us */
+    PAPIW::START_TIMESERIES("papiw_timeseries.csv", 100);
+
+    /* The event sets are built in the first iteration and reused afterwards */
+    for (int i = 0; i < 100; i++)
+    {
+#pragma omp parallel
+        {
+            PAPIW::START();
+            doFlops();
+            PAPIW::STOP();
+        }
+    }
+
+    PAPIW::STOP_TIMESERIES();
+
+    std::cout << "==========================> Do Flops 100 times <===========================" << std::endl;
+    PAPIW::PRINT();
+}
+
+void testRegions()
+{
+    PAPIW::INIT_PARALLEL_PERSISTENT(PAPI_L2_TCA, PAPI_L1_TCM, PAPI_L3_TCA, PAPI_L3_TCM);
+
+    /* Every region interval is recorded as well. Analyse it with: papiw_report --threads papiw_trace.bin */
+    PAPIW::START_TRACE("papiw_trace.bin");
+
+    /* Every region has its own values, so the whole pipeline can be measured in one run */
+    for (int i = 0; i < 10; i++)
+    {
+#pragma omp parallel
+        {
+            {
+                PAPIW_REGION("flops");
+                doFlops();
+            }
+            {
+                PAPIW::Region region("reads");
+                doReads();
+
+                /* Nested regions are recorded in a call tree */
+                PAPIW_REGION("misses");
+                doMisses();
+            }
+        }
+    }
+
+    PAPIW::STOP_TRACE();
+
+    PAPIW::PRINT_REGIONS();
+    PAPIW::PRINT_CALL_TREE();
+
+    /* Machine readable results for scripts */
+    PAPIW::EXPORT(PAPIW::Format::JSON, "papiw_regions.json");
+}
+
 void dummy(void *array)
 {
     (void)array;
@@ -2,6 +2,21 @@
 #define PAPIWRAPPER
 
 #include "./papiwrapperutil.h"
+#include "./papiwrapperregions.h"
+#include "./papiwrapperexport.h"
+#include "./papiwrappermetrics.h"
+#include "./papiwrappereventset.h"
+#include "./papiwrapperbackend.h"
+#include "./papiwrappersimulated.h"
+#include "./papiwrapperperf.h"
+
+/* Source of the counter values, see papiwrapperbackend.h */
+class PapiWrapperBackend;
+
+/* Number of empty START/STOP pairs measured by CALIBRATE */
+#ifndef PAPIW_CALIBRATION_REPETITIONS
+#define PAPIW_CALIBRATION_REPETITIONS 1000
+#endif
 
 /**
  * Papi Wrapper Highlevel Module
@@ -37,10 +52,26 @@ namespace PAPIW
 #endif
         } // namespace
 
+        /**
+     * Replace the source of the counter values, e.g. by a PapiWrapperSimulatedBackend for machines without
+     * hardware counters. The caller keeps the ownership of the backend
+     *
+     * @param backend The new backend or nullptr for libpapi
+     * @warning Has to be called before INIT and may not be changed until the last instance is gone
+     */
+        void SET_BACKEND(PapiWrapperBackend *backend)
+        {
+#if !defined(NOPAPIW)
+                PapiWrapperBackend::Set(backend);
+#else
+                sink{backend};
+#endif
+        }
+
         /**
      * Initialize Papi wrapper module for sequential use only
      *
-     * @tparam PapiCodes a variadic list of PAPI eventcodes
+     * @tparam PapiCodes a variadic list of PAPI eventcodes or event names, e.g. "perf::CONTEXT-SWITCHES"
      * @warning Exits with an error if called in a parallel region
      */
         template <typename... PapiCodes>
@@ -58,7 +89,7 @@ namespace PAPIW
         /**
      * Initialize Papi wrapper module for parallel use
      *
-     * @tparam PapiCodes a variadic list of PAPI eventcodes
+     * @tparam PapiCodes a variadic list of PAPI eventcodes or event names, e.g. "perf::CONTEXT-SWITCHES"
      * @warning Exits with an error if called in a parallel region
      */
         template <typename... PapiCodes>
@@ -75,6 +106,150 @@ namespace PAPIW
 #endif
         }
 
+        /**
+     * Initialize Papi wrapper module for sequential use with multiplexed events.
+     * This allows to count more events than there are hardware counters, but the values are scaled estimates
+     *
+     * @tparam PapiCodes a variadic list of PAPI eventcodes or event names, e.g. "perf::CONTEXT-SWITCHES"
+     * @warning Exits with an error if called in a parallel region
+     */
+        template <typename... PapiCodes>
+        void INIT_SINGLE_MULTIPLEXED(PapiCodes const... eventcodes)
+        {
+#if !defined(NOPAPIW)
+                delete papiwrapper;
+                papiwrapper = static_cast<PapiWrapper *>(new PapiWrapperSingle(true));
+                papiwrapper->Init(eventcodes...);
+#else
+                sink{eventcodes...};
+#endif
+        }
+
+        /**
+     * Initialize Papi wrapper module for parallel use with multiplexed events.
+     * This allows to count more events than there are hardware counters, but the values are scaled estimates
+     *
+     * @tparam PapiCodes a variadic list of PAPI eventcodes or event names, e.g. "perf::CONTEXT-SWITCHES"
+     * @warning Exits with an error if called in a parallel region
+     */
+        template <typename... PapiCodes>
+        void INIT_PARALLEL_MULTIPLEXED(PapiCodes const... eventcodes)
+        {
+#if !defined(_OPENMP)
+                INIT_SINGLE_MULTIPLEXED(eventcodes...);
+#elif !defined(NOPAPIW)
+                delete papiwrapper;
+                papiwrapper = static_cast<PapiWrapper *>(new PapiWrapperParallel(false, true));
+                papiwrapper->Init(eventcodes...);
+#else
+                sink{eventcodes...};
+#endif
+        }
+
+        /**
+     * Initialize Papi wrapper module for parallel use with persistent per-thread event sets.
+     * Every thread builds its event set once and only starts and stops it afterwards, which
+     * makes START/STOP cheap enough for short and frequently executed parallel regions
+     *
+     * @tparam PapiCodes a variadic list of PAPI eventcodes or event names, e.g. "perf::CONTEXT-SWITCHES"
+     * @warning Exits with an error if called in a parallel region
+     */
+        template <typename... PapiCodes>
+        void INIT_PARALLEL_PERSISTENT(PapiCodes const... eventcodes)
+        {
+#if !defined(_OPENMP)
+                INIT_SINGLE(eventcodes...);
+#elif !defined(NOPAPIW)
+                delete papiwrapper;
+                papiwrapper = static_cast<PapiWrapper *>(new PapiWrapperParallel(true));
+                papiwrapper->Init(eventcodes...);
+#else
+                sink{eventcodes...};
+#endif
+        }
+
+        /**
+     * Initialize Papi wrapper module for parallel use with a changing team size, e.g. with OMP_DYNAMIC.
+     * The counters may keep running across parallel regions of different widths. Threads which join later are
+     * registered by their first START or BEGIN_REGION, the counters of threads which left are harvested by STOP
+     *
+     * @tparam PapiCodes a variadic list of PAPI eventcodes or event names, e.g. "perf::CONTEXT-SWITCHES"
+     * @warning Exits with an error if called in a parallel region
+     */
+        template <typename... PapiCodes>
+        void INIT_PARALLEL_ELASTIC(PapiCodes const... eventcodes)
+        {
+#if !defined(_OPENMP)
+                INIT_SINGLE(eventcodes...);
+#elif !defined(NOPAPIW)
+                delete papiwrapper;
+                papiwrapper = static_cast<PapiWrapper *>(new PapiWrapperParallel(true, false, true));
+                papiwrapper->Init(eventcodes...);
+#else
+                sink{eventcodes...};
+#endif
+        }
+
+        /**
+     * Initialize Papi wrapper module for any threading model, e.g. std::thread, pthreads or thread pools.
+     * Every thread registers itself on its first START and then starts and stops its own counters
+     * independently. The results are summed up over all threads which ever counted, also after they exited
+     *
+     * @tparam PapiCodes a variadic list of PAPI eventcodes or event names, e.g. "perf::CONTEXT-SWITCHES"
+     * @warning START and STOP only affect the calling thread, also inside an omp parallel region
+     */
+        template <typename... PapiCodes>
+        void INIT_THREADS(PapiCodes const... eventcodes)
+        {
+#if !defined(NOPAPIW)
+                delete papiwrapper;
+                papiwrapper = static_cast<PapiWrapper *>(new PapiWrapperThreads());
+                papiwrapper->Init(eventcodes...);
+#else
+                sink{eventcodes...};
+#endif
+        }
+
+        /**
+     * Initialize Papi wrapper module for sequential use with more events than fit into one event set.
+     * The events are partitioned into groups which are counted one after another by MEASURE_PASSES
+     *
+     * @tparam PapiCodes a variadic list of PAPI eventcodes or event names, e.g. "perf::CONTEXT-SWITCHES"
+     * @warning Exits with an error if called in a parallel region
+     */
+        template <typename... PapiCodes>
+        void INIT_SINGLE_PASSES(PapiCodes const... eventcodes)
+        {
+#if !defined(NOPAPIW)
+                delete papiwrapper;
+                papiwrapper = static_cast<PapiWrapper *>(new PapiWrapperPasses());
+                papiwrapper->Init(eventcodes...);
+#else
+                sink{eventcodes...};
+#endif
+        }
+
+        /**
+     * Initialize Papi wrapper module for parallel use with more events than fit into one event set.
+     * The events are partitioned into groups which are counted one after another by MEASURE_PASSES
+     *
+     * @tparam PapiCodes a variadic list of PAPI eventcodes or event names, e.g. "perf::CONTEXT-SWITCHES"
+     * @warning Exits with an error if called in a parallel region
+     */
+        template <typename... PapiCodes>
+        void INIT_PARALLEL_PASSES(PapiCodes const... eventcodes)
+        {
+#if !defined(_OPENMP)
+                INIT_SINGLE_PASSES(eventcodes...);
+#elif !defined(NOPAPIW)
+                delete papiwrapper;
+                papiwrapper = static_cast<PapiWrapper *>(new PapiWrapperPasses(true));
+                papiwrapper->Init(eventcodes...);
+#else
+                sink{eventcodes...};
+#endif
+        }
+
         /* Start the counters */
         void START()
         {
@@ -102,6 +277,68 @@ namespace PAPIW
 #endif
         }
 
+        /**
+     * Run a deterministic function with running counters, once per pass if the events were initialized
+     * with INIT_*_PASSES and once otherwise. The results of all passes are merged
+     *
+     * Example of use:
+     *     PAPIW::INIT_SINGLE_PASSES(PAPI_TOT_INS, PAPI_TOT_CYC, PAPI_L1_DCM, PAPI_L2_DCM, PAPI_L3_TCM, PAPI_BR_MSP, PAPI_TLB_DM);
+     *     PAPIW::MEASURE_PASSES([]() { doWork(); });
+     *     PAPIW::PRINT();
+     *
+     * @warning Exits with an error if the counters are running. The function has to do the same work in every pass
+     */
+        template <typename Function>
+        void MEASURE_PASSES(Function function)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->MeasurePasses(function);
+#else
+                function();
+#endif
+        }
+
+        /**
+     * Keep the counters enabled and only read them in user space (rdpmc) on START, STOP and regions.
+     * This makes measuring very short regions cheap. If Papi can not use rdpmc, a warning is printed
+     * and the counters are started and stopped as before
+     *
+     * @warning Exits with an error if the counters are running or combined with multiplexing or sampling
+     */
+        void ENABLE_FAST_READ()
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->EnableFastRead();
+#endif
+        }
+
+        /**
+     * Measure the overhead of START/STOP by counting empty pairs on every thread and take the median per event.
+     * From then on, the overhead times the number of START/STOP intervals is subtracted from the results.
+     * Call it after INIT and ENABLE_FAST_READ, s.t. it measures the same mode. The counted values are reset
+     *
+     * @note Regions are not corrected
+     * @warning Exits with an error if the counters are running or if called in a parallel region
+     */
+        void CALIBRATE(const int repetitions = PAPIW_CALIBRATION_REPETITIONS)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->Calibrate(repetitions);
+#else
+                sink{repetitions};
+#endif
+        }
+
+        /* Turn the subtraction of the calibrated overhead on or off. CALIBRATE turns it on */
+        void CORRECT_OVERHEAD(const bool enabled)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->CorrectOverhead(enabled);
+#else
+                sink{enabled};
+#endif
+        }
+
         /**
      * Reset the Counters. Use this if you want to start fresh counters after a print
      *
@@ -111,6 +348,8 @@ namespace PAPIW
         {
 #if !defined(NOPAPIW)
                 papiwrapper->Reset();
+                papiwrapper->ResetEnergy();
+                papiwrapper->ResetDistribution();
 #endif
         }
 
@@ -125,8 +364,539 @@ namespace PAPIW
                 papiwrapper->Print();
 #endif
         }
+
+        /**
+     * Get the result of an event, summed up over all threads
+     *
+     * @warning Exits with an error if the event is not counted or the counters are running
+     */
+        long long GET_RESULT(const int eventCode)
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->GetResult(eventCode);
+#else
+                sink{eventCode};
+                return 0;
+#endif
+        }
+
+        /**
+     * Get the result of an event without the overhead correction, summed up over all threads
+     *
+     * @warning Exits with an error if the event is not counted or the counters are running
+     */
+        long long GET_RAW_RESULT(const int eventCode)
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->GetRawResult(eventCode);
+#else
+                sink{eventCode};
+                return 0;
+#endif
+        }
+
+        /**
+     * Get the result of an event for every OpenMP nesting level, starting with the outermost team.
+     * A thread belongs to the outermost level on which it was part of a team, the master of a nested team
+     * is therefore counted on the enclosing level. Sequential instances return only one level
+     *
+     * @warning Exits with an error if the event is not counted or the counters are running
+     */
+        std::vector<long long> GET_LEVEL_RESULTS(const int eventCode)
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->GetLevelResults(eventCode);
+#else
+                sink{eventCode};
+                return {};
+#endif
+        }
+
+        /**
+     * Compute a user defined metric from the counted events. It is printed by PRINT next to the standard
+     * metrics, which are computed whenever all their events are counted (e.g. IPC for PAPI_TOT_INS and PAPI_TOT_CYC)
+     *
+     * Example of use:
+     *     PAPIW::INIT_SINGLE(PAPI_LD_INS, PAPI_SR_INS);
+     *     PAPIW::ADD_METRIC(PapiWrapperMetric::Ratio("LD_PER_ST", "Loads per store", PAPI_LD_INS, PAPI_SR_INS));
+     *
+     * @note Has to be called after INIT. A warning is issued if not all events of the metric are counted
+     */
+        void ADD_METRIC(const PapiWrapperMetric &metric)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->AddMetric(metric);
+#else
+                sink{metric};
+#endif
+        }
+
+        /**
+     * Get the value of a derived metric by its name, e.g. "IPC". NaN if it is undefined
+     *
+     * @warning Exits with an error if the metric is unknown or the counters are running
+     */
+        double GET_METRIC(const char *name)
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->GetMetric(name);
+#else
+                sink{name};
+                return NAN;
+#endif
+        }
+
+        /**
+     * Write the results as JSON, CSV or in the Prometheus text format to a file.
+     * The file is replaced atomically, s.t. it can be exported periodically
+     *
+     * Example of use:
+     *     PAPIW::EXPORT(PAPIW::Format::JSON, "counters.json");
+     *
+     * @warning Exits with an error if the counters are running while calling EXPORT
+     */
+        void EXPORT(const Format format, const char *path)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->Export(PapiWrapperExporter::Get(format), path);
+#else
+                sink{format, path};
+#endif
+        }
+
+        /**
+     * Write the results with a custom exporter to a file
+     */
+        void EXPORT(PapiWrapperExporter &exporter, const char *path)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->Export(exporter, path);
+#else
+                sink{exporter, path};
+#endif
+        }
+
+        /**
+     * Write the results as JSON, CSV or in the Prometheus text format to a buffer of the caller
+     *
+     * @return The length of the output. If it is not smaller than size, the output was truncated
+     */
+        size_t EXPORT(const Format format, char *buffer, const size_t size)
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->Export(PapiWrapperExporter::Get(format), buffer, size);
+#else
+                sink{format};
+                if (size != 0)
+                        buffer[0] = '\0';
+                return 0;
+#endif
+        }
+
+        /**
+     * Write the results with a custom exporter to a buffer of the caller
+     *
+     * @return The length of the output. If it is not smaller than size, the output was truncated
+     */
+        size_t EXPORT(PapiWrapperExporter &exporter, char *buffer, const size_t size)
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->Export(exporter, buffer, size);
+#else
+                sink{exporter};
+                if (size != 0)
+                        buffer[0] = '\0';
+                return 0;
+#endif
+        }
+
+        /**
+     * Additionally export the results to a file on every PRINT
+     *
+     * @param replacePrint If true, PRINT only exports and does not write the human readable text anymore
+     */
+        void EXPORT_ON_PRINT(const Format format, const char *path, const bool replacePrint = false)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->ExportOnPrint(PapiWrapperExporter::Get(format), path, replacePrint);
+#else
+                sink{format, path, replacePrint};
+#endif
+        }
+
+        /**
+     * Print the values of every thread together with min, max, mean, standard deviation
+     * and the load imbalance (max / mean) of each event
+     *
+     * @warning Exits with an error if the counters are running while calling PRINT_THREADS
+     */
+        void PRINT_THREADS()
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->PrintThreads();
+#endif
+        }
+
+        /**
+     * Print the cpu and NUMA node every thread started and stopped its last interval on, the number of
+     * intervals in which it migrated to another cpu and the results per socket and per core.
+     * The values of an interval are attributed to the cpu it was started on
+     *
+     * @warning Exits with an error if the counters are running while calling PRINT_PLACEMENT
+     */
+        void PRINT_PLACEMENT()
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->PrintPlacement();
+#endif
+        }
+
+        /**
+     * Get the result of an event for every socket, by the cpu the intervals were started on.
+     * Sequential instances return only one socket
+     *
+     * @warning Exits with an error if the event is not counted or the counters are running
+     */
+        std::vector<long long> GET_SOCKET_RESULTS(const int eventCode)
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->GetSocketResults(eventCode);
+#else
+                sink{eventCode};
+                return {};
+#endif
+        }
+
+        /**
+     * Check whether an event is counted, i.e. it was passed to INIT and is available on the system.
+     * Always false if PAPIW is disabled
+     */
+        bool IS_COUNTED(const int eventCode)
+        {
+#if !defined(NOPAPIW)
+                auto &events = papiwrapper->GetEvents();
+                return std::find(events.begin(), events.end(), eventCode) != events.end();
+#else
+                sink{eventCode};
+                return false;
+#endif
+        }
+
+        /**
+     * Record the instruction pointer whenever eventCode occurred threshold times.
+     * Has to be called after INIT and before the counters are started the first time
+     *
+     * Example of use:
+     *     PAPIW::INIT_SINGLE(PAPI_TOT_CYC, PAPI_L3_TCM);
+     *     PAPIW::SAMPLE(PAPI_L3_TCM, 100000);
+     *
+     * @warning Exits with an error for multiplexed events, events which are not counted (see IS_COUNTED)
+     *          or if the counters are running
+     */
+        void SAMPLE(const int eventCode, const int threshold)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->EnableSampling(eventCode, threshold);
+#else
+                sink{eventCode, threshold};
+#endif
+        }
+
+        /**
+     * Print the functions and addresses with the most samples for every sampled event
+     *
+     * @warning Exits with an error if the counters are running while calling PRINT_SAMPLES
+     */
+        void PRINT_SAMPLES()
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->PrintSamples();
+#endif
+        }
+
+        /**
+     * Write the values of the running counters of every thread periodically to a CSV file.
+     * The counters are read in the background while they keep running
+     *
+     * Example of use:
+     *     PAPIW::INIT_PARALLEL(PAPI_TOT_INS, PAPI_L3_TCM);
+     *     PAPIW::START_TIMESERIES("counters.csv", 1000);
+     *     PAPIW::START();
+     *     doWork();
+     *     PAPIW::STOP();
+     *     PAPIW::STOP_TIMESERIES();
+     *
+     * @param path File the samples are written to
+     * @param intervalMicroseconds Time between two samples of a thread
+     */
+        void START_TIMESERIES(const char *path, const long long intervalMicroseconds)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->StartTimeSeries(path, intervalMicroseconds * 1000);
+#else
+                sink{path, intervalMicroseconds};
+#endif
+        }
+
+        /**
+     * Stop the periodic sampling and flush the remaining samples to the file
+     *
+     * @warning The counters must not be running while calling STOP_TIMESERIES
+     */
+        void STOP_TIMESERIES()
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->StopTimeSeries();
+#endif
+        }
+
+        /**
+     * Record the counter deltas of every START/STOP interval and every named region into a binary trace.
+     * Use the papiw_report tool to turn the trace into tables or CSV
+     *
+     * Example of use:
+     *     PAPIW::INIT_PARALLEL(PAPI_TOT_INS, PAPI_L3_TCM);
+     *     PAPIW::START_TRACE("run.papiw");
+     *     for (...)
+     *     {
+     *         PAPIW::START();
+     *         doWork();
+     *         PAPIW::STOP();
+     *     }
+     *     PAPIW::STOP_TRACE();
+     */
+        void START_TRACE(const char *path)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->StartTrace(path);
+#else
+                sink{path};
+#endif
+        }
+
+        /**
+     * Stop recording and complete the trace file
+     *
+     * @warning The counters must not be running while calling STOP_TRACE
+     */
+        void STOP_TRACE()
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->StopTrace();
+#endif
+        }
+
+        /**
+     * Measure the energy of the RAPL zones of the powercap interface, i.e. per socket and its core,
+     * uncore and dram subzones. PRINT and PRINT_REGIONS report the joules next to the counters
+     *
+     * Example of use:
+     *     PAPIW::INIT_PARALLEL(PAPI_TOT_INS, PAPI_TOT_CYC);
+     *     PAPIW::ENABLE_ENERGY();
+     *     PAPIW::START();
+     *     doWork();
+     *     PAPIW::STOP();
+     *     PAPIW::PRINT();
+     *
+     * @param root Root of the powercap sysfs tree, e.g. a fake tree for testing. Defaults to PAPIW_ENERGY_ROOT
+     * @warning Has to be called after INIT and while the counters are not running
+     */
+        void ENABLE_ENERGY(const char *root = nullptr)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->EnableEnergy(root);
+#else
+                sink{root};
+#endif
+        }
+
+        /**
+     * Get the names of the measured RAPL zones in the order of the values of GET_ENERGY
+     */
+        std::vector<std::string> GET_ENERGY_ZONES()
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->GetEnergyZones();
+#else
+                return {};
+#endif
+        }
+
+        /**
+     * Get the joules of every RAPL zone in the intervals from START to STOP
+     */
+        std::vector<double> GET_ENERGY()
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->GetEnergy();
+#else
+                return {};
+#endif
+        }
+
+        /**
+     * Get the joules of every RAPL zone in a named region
+     */
+        std::vector<double> GET_REGION_ENERGY(const RegionName &name)
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->GetEnergy(name.hash);
+#else
+                sink{name};
+                return {};
+#endif
+        }
+
+        /**
+     * Record the counter values of every interval from START to STOP and of every instance of a named region
+     * into log-bucketed histograms of every thread. PRINT reports p50, p90, p99, p99.9 and the maximum
+     *
+     * Example of use:
+     *     PAPIW::INIT_PARALLEL(PAPI_TOT_CYC, PAPI_L3_TCM);
+     *     PAPIW::ENABLE_DISTRIBUTION();
+     *     for (auto &request : requests)
+     *     {
+     *         PAPIW_REGION("request");
+     *         handle(request);
+     *     }
+     *     PAPIW::PRINT();
+     *
+     * @note The values are accurate to PAPIW_HISTOGRAM_PRECISION bits and are not corrected by the calibrated overhead
+     * @warning Has to be called after INIT and while the counters are not running
+     */
+        void ENABLE_DISTRIBUTION()
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->EnableDistribution();
+#endif
+        }
+
+        /**
+     * Get a percentile, e.g. 99.9, of the values of an event per interval from START to STOP. 0 if nothing was recorded
+     */
+        long long GET_PERCENTILE(const int eventCode, const double percentile)
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->GetPercentile(eventCode, percentile);
+#else
+                sink{eventCode, percentile};
+                return 0;
+#endif
+        }
+
+        /**
+     * Get a percentile, e.g. 99.9, of the values of an event per instance of a named region. 0 if nothing was recorded
+     */
+        long long GET_REGION_PERCENTILE(const RegionName &name, const int eventCode, const double percentile)
+        {
+#if !defined(NOPAPIW)
+                return papiwrapper->GetPercentile(eventCode, percentile, name.hash);
+#else
+                sink{name, eventCode, percentile};
+                return 0;
+#endif
+        }
+
+        /**
+     * Print the percentiles of every event in the intervals and in every named region
+     *
+     * @warning Has to be called while the counters are not running
+     */
+        void PRINT_DISTRIBUTION()
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->PrintDistribution();
+#endif
+        }
+
+        /**
+     * Start measuring a named region. Prefer the RAII helpers Region and PAPIW_REGION
+     *
+     * @note The counters are started for the region if they are not running yet
+     */
+        void BEGIN_REGION(const RegionName &name)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->BeginRegion(name);
+#else
+                sink{name};
+#endif
+        }
+
+        /**
+     * Stop measuring the innermost named region
+     *
+     * @warning Exits with an error if name is not the innermost region
+     */
+        void END_REGION(const RegionName &name)
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->EndRegion(name);
+#else
+                sink{name};
+#endif
+        }
+
+        /**
+     * Print the values of all named regions
+     *
+     * @warning Exits with an error if the counters are running while calling PRINT_REGIONS
+     */
+        void PRINT_REGIONS()
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->PrintRegions();
+#endif
+        }
+
+        /**
+     * Print the inclusive and exclusive values of nested regions per call path.
+     * In parallel use, the call trees of all threads are merged
+     *
+     * @warning Exits with an error if the counters are running while calling PRINT_CALL_TREE
+     */
+        void PRINT_CALL_TREE()
+        {
+#if !defined(NOPAPIW)
+                papiwrapper->PrintCallTree();
+#endif
+        }
+
+        /**
+     * Measures a named region for the lifetime of the object
+     *
+     * Example of use:
+     *     {
+     *         PAPIW::Region region("parse");
+     *         parse();
+     *     }
+     *     PAPIW::PRINT_REGIONS();
+     */
+        class Region
+        {
+        public:
+                Region(const RegionName &name) : name(name)
+                {
+                        BEGIN_REGION(name);
+                }
+                ~Region()
+                {
+                        END_REGION(name);
+                }
+                Region(const Region &) = delete;
+                Region &operator=(const Region &) = delete;
+
+        private:
+                const RegionName name;
+        };
 } // namespace PAPIW
 
+/* Measure the rest of the enclosing scope as named region. The hash of the name is computed at compile time */
+#define PAPIW_CONCAT_(a, b) a##b
+#define PAPIW_CONCAT(a, b) PAPIW_CONCAT_(a, b)
+#define PAPIW_REGION(name)                                                                      \
+        static constexpr PAPIW::RegionName PAPIW_CONCAT(papiwRegionName, __LINE__){name};       \
+        PAPIW::Region PAPIW_CONCAT(papiwRegion, __LINE__) { PAPIW_CONCAT(papiwRegionName, __LINE__) }
 #ifdef NOPAPIW
 /* Provide PAPI Counter Macros, s.t. a program with deactivated PAPIW compiles nevertheless */
 #define PAPI_L1_DCM 0
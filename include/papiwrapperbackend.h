@@ -0,0 +1,249 @@
+#ifndef PAPIWRAPPERBACKEND
+#define PAPIWRAPPERBACKEND
+#ifndef NOPAPIW
+
+#include <pthread.h>
+#include <string>
+#include "./papiwrapperpapi.h"
+
+/**
+ * Source of the counter values
+ *
+ * All PapiWrapper classes access the counters only through the active backend. Every operation mirrors
+ * the Papi function of the same name and returns its status codes, e.g. PAPI_OK or PAPI_ENOEVNT, s.t.
+ * the error handling does not depend on the backend. The default backend is libpapi itself, or the
+ * perf_event_open backend in builds without libpapi (PAPIW_PERF_EVENT).
+ */
+class PapiWrapperBackend
+{
+public:
+    virtual ~PapiWrapperBackend() {}
+
+    /* Name of the backend, e.g. "papi" */
+    virtual const char *Name() = 0;
+
+    /* Library */
+    virtual int LibraryInit() = 0;
+    virtual int MultiplexInit() = 0;
+
+    /* Threads are identified by pthread_self */
+    virtual int ThreadInit() = 0;
+    virtual int RegisterThread() = 0;
+    virtual int UnregisterThread() = 0;
+    virtual unsigned long ThreadId() = 0;
+
+    /* Event sets */
+    virtual int CreateEventSet(int *eventSet) = 0;
+    virtual int AssignEventSetComponent(const int eventSet, const int component) = 0;
+    virtual int SetMultiplex(const int eventSet) = 0;
+    virtual int AddEvent(const int eventSet, const int eventCode) = 0;
+    virtual int CleanupEventSet(const int eventSet) = 0;
+    virtual int DestroyEventSet(int *eventSet) = 0;
+
+    /* Counting. Read returns the values since Start, Accum adds them to values and resets the counters */
+    virtual int Start(const int eventSet) = 0;
+    virtual int Stop(const int eventSet, long long *values) = 0;
+    virtual int Read(const int eventSet, long long *values) = 0;
+    virtual int Accum(const int eventSet, long long *values) = 0;
+
+    /* Clocks in nanoseconds. The virtual time is the cpu time of the calling thread */
+    virtual long long GetRealNsec() = 0;
+    virtual long long GetVirtNsec() = 0;
+
+    /* Events */
+    virtual int QueryEvent(const int eventCode) = 0;
+    virtual int EventNameToCode(const char *name, int *eventCode) = 0;
+    virtual int EventCodeToName(const int eventCode, char *name) = 0; // name holds PAPI_MAX_STR_LEN characters
+    virtual int GetEventInfo(const int eventCode, std::string &symbol, std::string &description, std::string &units) = 0;
+
+    /* True if the counters of the cpu component are read in user space, e.g. with rdpmc */
+    virtual bool FastCounterRead() = 0;
+
+    /* Sampling */
+    virtual int Overflow(const int eventSet, const int eventCode, const int threshold, PAPI_overflow_handler_t handler) = 0;
+    virtual int GetOverflowEventIndex(const int eventSet, const long long overflowVector, int *indices, int *number) = 0;
+
+    /* Get the backend used by all PapiWrapper instances */
+    static PapiWrapperBackend &Get()
+    {
+        return active != nullptr ? *active : Default();
+    }
+
+    /**
+     * Replace the backend used by all PapiWrapper instances. The caller keeps the ownership
+     *
+     * @param backend The new backend or nullptr for the default backend
+     * @warning Has to be called before the first instance is initialized and may not be changed while instances exist
+     */
+    static void Set(PapiWrapperBackend *backend)
+    {
+        active = backend;
+    }
+
+    /* The default backend, which forwards every call to libpapi or to perf_event_open */
+    static PapiWrapperBackend &Default();
+
+private:
+    inline static PapiWrapperBackend *active = nullptr;
+};
+
+#ifndef PAPIW_PERF_EVENT
+/**
+ * Backend which forwards every call to libpapi
+ */
+class PapiWrapperPapiBackend : public PapiWrapperBackend
+{
+public:
+    const char *Name() override
+    {
+        return "papi";
+    }
+
+    int LibraryInit() override
+    {
+        int retval = PAPI_library_init(PAPI_VER_CURRENT);
+        return retval == PAPI_VER_CURRENT ? PAPI_OK : retval;
+    }
+
+    int MultiplexInit() override
+    {
+        return PAPI_multiplex_init();
+    }
+
+    int ThreadInit() override
+    {
+        return PAPI_thread_init(pthread_self);
+    }
+
+    int RegisterThread() override
+    {
+        return PAPI_register_thread();
+    }
+
+    int UnregisterThread() override
+    {
+        return PAPI_unregister_thread();
+    }
+
+    unsigned long ThreadId() override
+    {
+        return PAPI_thread_id();
+    }
+
+    int CreateEventSet(int *eventSet) override
+    {
+        return PAPI_create_eventset(eventSet);
+    }
+
+    int AssignEventSetComponent(const int eventSet, const int component) override
+    {
+        return PAPI_assign_eventset_component(eventSet, component);
+    }
+
+    int SetMultiplex(const int eventSet) override
+    {
+        return PAPI_set_multiplex(eventSet);
+    }
+
+    int AddEvent(const int eventSet, const int eventCode) override
+    {
+        return PAPI_add_event(eventSet, eventCode);
+    }
+
+    int CleanupEventSet(const int eventSet) override
+    {
+        return PAPI_cleanup_eventset(eventSet);
+    }
+
+    int DestroyEventSet(int *eventSet) override
+    {
+        return PAPI_destroy_eventset(eventSet);
+    }
+
+    int Start(const int eventSet) override
+    {
+        return PAPI_start(eventSet);
+    }
+
+    int Stop(const int eventSet, long long *values) override
+    {
+        return PAPI_stop(eventSet, values);
+    }
+
+    int Read(const int eventSet, long long *values) override
+    {
+        return PAPI_read(eventSet, values);
+    }
+
+    int Accum(const int eventSet, long long *values) override
+    {
+        return PAPI_accum(eventSet, values);
+    }
+
+    long long GetRealNsec() override
+    {
+        return PAPI_get_real_nsec();
+    }
+
+    long long GetVirtNsec() override
+    {
+        return PAPI_get_virt_nsec();
+    }
+
+    int QueryEvent(const int eventCode) override
+    {
+        return PAPI_query_event(eventCode);
+    }
+
+    int EventNameToCode(const char *name, int *eventCode) override
+    {
+        return PAPI_event_name_to_code(const_cast<char *>(name), eventCode);
+    }
+
+    int EventCodeToName(const int eventCode, char *name) override
+    {
+        return PAPI_event_code_to_name(eventCode, name);
+    }
+
+    int GetEventInfo(const int eventCode, std::string &symbol, std::string &description, std::string &units) override
+    {
+        PAPI_event_info_t info;
+        int retval = PAPI_get_event_info(eventCode, &info);
+        if (retval != PAPI_OK)
+            return retval;
+
+        symbol = info.symbol;
+        description = info.long_descr[0] != '\0' ? info.long_descr : info.short_descr;
+        units = info.units;
+        return PAPI_OK;
+    }
+
+    bool FastCounterRead() override
+    {
+        auto component = PAPI_get_component_info(0);
+        return component != nullptr && component->fast_counter_read;
+    }
+
+    int Overflow(const int eventSet, const int eventCode, const int threshold, PAPI_overflow_handler_t handler) override
+    {
+        return PAPI_overflow(eventSet, eventCode, threshold, 0, handler);
+    }
+
+    int GetOverflowEventIndex(const int eventSet, const long long overflowVector, int *indices, int *number) override
+    {
+        return PAPI_get_overflow_event_index(eventSet, overflowVector, indices, number);
+    }
+};
+
+inline PapiWrapperBackend &PapiWrapperBackend::Default()
+{
+    static PapiWrapperPapiBackend papi;
+    return papi;
+}
+#else
+/* Defines PapiWrapperBackend::Default() */
+#include "./papiwrapperperf.h"
+#endif
+
+#endif
+#endif
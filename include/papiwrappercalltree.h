@@ -0,0 +1,155 @@
+#ifndef PAPIWRAPPERCALLTREE
+#define PAPIWRAPPERCALLTREE
+
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+/* Size of one arena block in bytes */
+#ifndef PAPIW_ARENA_BLOCK_SIZE
+#define PAPIW_ARENA_BLOCK_SIZE (64 * 1024)
+#endif
+
+/**
+ * Bump pointer allocator for call tree nodes
+ *
+ * Memory is taken from large blocks and only released as a whole on destruction.
+ * Thus, allocating a node only hits malloc whenever a block is exhausted.
+ */
+class PapiWrapperArena
+{
+private:
+    std::vector<char *> blocks;
+    size_t used = PAPIW_ARENA_BLOCK_SIZE; // Bytes used in the last block
+
+public:
+    PapiWrapperArena() {}
+    ~PapiWrapperArena()
+    {
+        for (auto block : blocks)
+            delete[] block;
+    }
+    PapiWrapperArena(const PapiWrapperArena &) = delete;
+    PapiWrapperArena &operator=(const PapiWrapperArena &) = delete;
+
+    /* Get uninitialized memory of the given size, aligned to alignof(max_align_t) */
+    void *Allocate(size_t size)
+    {
+        size = (size + alignof(max_align_t) - 1) / alignof(max_align_t) * alignof(max_align_t);
+        if (used + size > PAPIW_ARENA_BLOCK_SIZE)
+        {
+            blocks.push_back(new char[std::max<size_t>(size, PAPIW_ARENA_BLOCK_SIZE)]);
+            used = 0;
+        }
+
+        void *memory = blocks.back() + used;
+        used += size;
+        return memory;
+    }
+};
+
+/**
+ * Call tree of nested regions of one thread
+ *
+ * Every node holds the inclusive values of a region at one specific call path.
+ * The exclusive values are the inclusive ones minus the inclusive values of all children.
+ */
+class PapiWrapperCallTree
+{
+public:
+    struct Node
+    {
+        uint64_t hash;
+        const char *name;
+        Node *parent;
+        Node *child;   // First child
+        Node *sibling; // Next child of the parent
+        long long intervals;
+        long long *values; // Inclusive values, one per event
+    };
+
+private:
+    const int eventCount;
+    PapiWrapperArena arena;
+    Node *root;
+
+public:
+    PapiWrapperCallTree(const int eventCount) : eventCount(eventCount)
+    {
+        root = newNode(nullptr, 0, "");
+    }
+    PapiWrapperCallTree(const PapiWrapperCallTree &) = delete;
+    PapiWrapperCallTree &operator=(const PapiWrapperCallTree &) = delete;
+
+    /* Node above all regions. It holds no values */
+    Node *Root() const
+    {
+        return root;
+    }
+
+    /* Get the child of a node with the given name, inserting it on first use */
+    Node *Child(Node *parent, const uint64_t hash, const char *name)
+    {
+        Node **link = &parent->child;
+        for (; *link != nullptr; link = &(*link)->sibling)
+            if ((*link)->hash == hash)
+                return *link;
+
+        *link = newNode(parent, hash, name);
+        return *link;
+    }
+
+    /* Add the values of another thread's tree, matching nodes by their call path */
+    void Add(const PapiWrapperCallTree &other)
+    {
+        add(root, other.root);
+    }
+
+    /* Set all values to zero but keep the known nodes */
+    void Reset()
+    {
+        reset(root);
+    }
+
+    /* Get the exclusive value of an event of a node */
+    long long Exclusive(const Node *node, const int index) const
+    {
+        long long value = node->values[index];
+        for (auto child = node->child; child != nullptr; child = child->sibling)
+            value -= child->values[index];
+        return value;
+    }
+
+private:
+    Node *newNode(Node *parent, const uint64_t hash, const char *name)
+    {
+        auto node = new (arena.Allocate(sizeof(Node))) Node{hash, name, parent, nullptr, nullptr, 0, nullptr};
+        node->values = static_cast<long long *>(arena.Allocate(sizeof(long long) * eventCount));
+        std::fill(node->values, node->values + eventCount, 0);
+        return node;
+    }
+
+    void add(Node *target, const Node *source)
+    {
+        for (auto child = source->child; child != nullptr; child = child->sibling)
+        {
+            auto targetChild = Child(target, child->hash, child->name);
+            for (int i = 0; i < eventCount; i++)
+                targetChild->values[i] += child->values[i];
+            targetChild->intervals += child->intervals;
+            add(targetChild, child);
+        }
+    }
+
+    void reset(Node *node)
+    {
+        std::fill(node->values, node->values + eventCount, 0);
+        node->intervals = 0;
+        for (auto child = node->child; child != nullptr; child = child->sibling)
+            reset(child);
+    }
+};
+
+#endif
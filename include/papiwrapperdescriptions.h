@@ -0,0 +1,229 @@
+#ifndef PAPIWRAPPERDESCRIPTIONS
+#define PAPIWRAPPERDESCRIPTIONS
+#ifndef NOPAPIW
+
+#include "./papiwrapperpapi.h"
+#include "./papiwrapperbackend.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace PAPIW
+{
+    /* Description of a preset event */
+    struct EventDescription
+    {
+        int code;
+        const char *description;
+    };
+
+    /* Descriptions of the preset events in the form "<name> (<description>)" */
+    constexpr EventDescription PresetDescriptions[] = {
+        {PAPI_L1_DCM, "PAPI_L1_DCM (Level 1 data cache misses)"},
+        {PAPI_L1_ICM, "PAPI_L1_ICM (Level 1 instruction cache misses)"},
+        {PAPI_L2_DCM, "PAPI_L2_DCM (Level 2 data cache misses)"},
+        {PAPI_L2_ICM, "PAPI_L2_ICM (Level 2 instruction cache misses)"},
+        {PAPI_L3_DCM, "PAPI_L3_DCM (Level 3 data cache misses)"},
+        {PAPI_L3_ICM, "PAPI_L3_ICM (Level 3 instruction cache misses)"},
+        {PAPI_L1_TCM, "PAPI_L1_TCM (Level 1 total cache misses)"},
+        {PAPI_L2_TCM, "PAPI_L2_TCM (Level 2 total cache misses)"},
+        {PAPI_L3_TCM, "PAPI_L3_TCM (Level 3 total cache misses)"},
+        {PAPI_CA_SNP, "PAPI_CA_SNP (Snoops)"},
+        {PAPI_CA_SHR, "PAPI_CA_SHR (Request for shared cache line (SMP))"},
+        {PAPI_CA_CLN, "PAPI_CA_CLN (Request for clean cache line (SMP))"},
+        {PAPI_CA_INV, "PAPI_CA_INV (Request for cache line Invalidation (SMP))"},
+        {PAPI_CA_ITV, "PAPI_CA_ITV (Request for cache line Intervention (SMP))"},
+        {PAPI_L3_LDM, "PAPI_L3_LDM (Level 3 load misses)"},
+        {PAPI_L3_STM, "PAPI_L3_STM (Level 3 store misses)"},
+        {PAPI_BRU_IDL, "PAPI_BRU_IDL (Cycles branch units are idle)"},
+        {PAPI_FXU_IDL, "PAPI_FXU_IDL (Cycles integer units are idle)"},
+        {PAPI_FPU_IDL, "PAPI_FPU_IDL (Cycles floating point units are idle)"},
+        {PAPI_LSU_IDL, "PAPI_LSU_IDL (Cycles load/store units are idle)"},
+        {PAPI_TLB_DM, "PAPI_TLB_DM (Data translation lookaside buffer misses)"},
+        {PAPI_TLB_IM, "PAPI_TLB_IM (Instr translation lookaside buffer misses)"},
+        {PAPI_TLB_TL, "PAPI_TLB_TL (Total translation lookaside buffer misses)"},
+        {PAPI_L1_LDM, "PAPI_L1_LDM (Level 1 load misses)"},
+        {PAPI_L1_STM, "PAPI_L1_STM (Level 1 store misses)"},
+        {PAPI_L2_LDM, "PAPI_L2_LDM (Level 2 load misses)"},
+        {PAPI_L2_STM, "PAPI_L2_STM (Level 2 store misses)"},
+        {PAPI_BTAC_M, "PAPI_BTAC_M (BTAC miss)"},
+        {PAPI_PRF_DM, "PAPI_PRF_DM (Prefetch data instruction caused a miss)"},
+        {PAPI_L3_DCH, "PAPI_L3_DCH (Level 3 Data Cache Hit)"},
+        {PAPI_TLB_SD, "PAPI_TLB_SD (Xlation lookaside buffer shootdowns (SMP))"},
+        {PAPI_CSR_FAL, "PAPI_CSR_FAL (Failed store conditional instructions)"},
+        {PAPI_CSR_SUC, "PAPI_CSR_SUC (Successful store conditional instructions)"},
+        {PAPI_CSR_TOT, "PAPI_CSR_TOT (Total store conditional instructions)"},
+        {PAPI_MEM_SCY, "PAPI_MEM_SCY (Cycles Stalled Waiting for Memory Access)"},
+        {PAPI_MEM_RCY, "PAPI_MEM_RCY (Cycles Stalled Waiting for Memory Read)"},
+        {PAPI_MEM_WCY, "PAPI_MEM_WCY (Cycles Stalled Waiting for Memory Write)"},
+        {PAPI_STL_ICY, "PAPI_STL_ICY (Cycles with No Instruction Issue)"},
+        {PAPI_FUL_ICY, "PAPI_FUL_ICY (Cycles with Maximum Instruction Issue)"},
+        {PAPI_STL_CCY, "PAPI_STL_CCY (Cycles with No Instruction Completion)"},
+        {PAPI_FUL_CCY, "PAPI_FUL_CCY (Cycles with Maximum Instruction Completion)"},
+        {PAPI_HW_INT, "PAPI_HW_INT (Hardware interrupts)"},
+        {PAPI_BR_UCN, "PAPI_BR_UCN (Unconditional branch instructions executed)"},
+        {PAPI_BR_CN, "PAPI_BR_CN (Conditional branch instructions executed)"},
+        {PAPI_BR_TKN, "PAPI_BR_TKN (Conditional branch instructions taken)"},
+        {PAPI_BR_NTK, "PAPI_BR_NTK (Conditional branch instructions not taken)"},
+        {PAPI_BR_MSP, "PAPI_BR_MSP (Conditional branch instructions mispred)"},
+        {PAPI_BR_PRC, "PAPI_BR_PRC (Conditional branch instructions corr. pred)"},
+        {PAPI_FMA_INS, "PAPI_FMA_INS (FMA instructions completed)"},
+        {PAPI_TOT_IIS, "PAPI_TOT_IIS (Total instructions issued)"},
+        {PAPI_TOT_INS, "PAPI_TOT_INS (Total instructions executed)"},
+        {PAPI_INT_INS, "PAPI_INT_INS (Integer instructions executed)"},
+        {PAPI_FP_INS, "PAPI_FP_INS (Floating point instructions executed)"},
+        {PAPI_LD_INS, "PAPI_LD_INS (Load instructions executed)"},
+        {PAPI_SR_INS, "PAPI_SR_INS (Store instructions executed)"},
+        {PAPI_BR_INS, "PAPI_BR_INS (Total branch instructions executed)"},
+        {PAPI_VEC_INS, "PAPI_VEC_INS (Vector/SIMD instructions executed (could include integer))"},
+        {PAPI_RES_STL, "PAPI_RES_STL (Cycles processor is stalled on resource)"},
+        {PAPI_FP_STAL, "PAPI_FP_STAL (Cycles any FP units are stalled)"},
+        {PAPI_TOT_CYC, "PAPI_TOT_CYC (Total cycles executed)"},
+        {PAPI_LST_INS, "PAPI_LST_INS (Total load/store inst. executed)"},
+        {PAPI_SYC_INS, "PAPI_SYC_INS (Sync. inst. executed)"},
+        {PAPI_L1_DCH, "PAPI_L1_DCH (L1 D Cache Hit)"},
+        {PAPI_L2_DCH, "PAPI_L2_DCH (L2 D Cache Hit)"},
+        {PAPI_L1_DCA, "PAPI_L1_DCA (L1 D Cache Access)"},
+        {PAPI_L2_DCA, "PAPI_L2_DCA (L2 D Cache Access)"},
+        {PAPI_L3_DCA, "PAPI_L3_DCA (L3 D Cache Access)"},
+        {PAPI_L1_DCR, "PAPI_L1_DCR (L1 D Cache Read)"},
+        {PAPI_L2_DCR, "PAPI_L2_DCR (L2 D Cache Read)"},
+        {PAPI_L3_DCR, "PAPI_L3_DCR (L3 D Cache Read)"},
+        {PAPI_L1_DCW, "PAPI_L1_DCW (L1 D Cache Write)"},
+        {PAPI_L2_DCW, "PAPI_L2_DCW (L2 D Cache Write)"},
+        {PAPI_L3_DCW, "PAPI_L3_DCW (L3 D Cache Write)"},
+        {PAPI_L1_ICH, "PAPI_L1_ICH (L1 instruction cache hits)"},
+        {PAPI_L2_ICH, "PAPI_L2_ICH (L2 instruction cache hits)"},
+        {PAPI_L3_ICH, "PAPI_L3_ICH (L3 instruction cache hits)"},
+        {PAPI_L1_ICA, "PAPI_L1_ICA (L1 instruction cache accesses)"},
+        {PAPI_L2_ICA, "PAPI_L2_ICA (L2 instruction cache accesses)"},
+        {PAPI_L3_ICA, "PAPI_L3_ICA (L3 instruction cache accesses)"},
+        {PAPI_L1_ICR, "PAPI_L1_ICR (L1 instruction cache reads)"},
+        {PAPI_L2_ICR, "PAPI_L2_ICR (L2 instruction cache reads)"},
+        {PAPI_L3_ICR, "PAPI_L3_ICR (L3 instruction cache reads)"},
+        {PAPI_L1_ICW, "PAPI_L1_ICW (L1 instruction cache writes)"},
+        {PAPI_L2_ICW, "PAPI_L2_ICW (L2 instruction cache writes)"},
+        {PAPI_L3_ICW, "PAPI_L3_ICW (L3 instruction cache writes)"},
+        {PAPI_L1_TCH, "PAPI_L1_TCH (L1 total cache hits)"},
+        {PAPI_L2_TCH, "PAPI_L2_TCH (L2 total cache hits)"},
+        {PAPI_L3_TCH, "PAPI_L3_TCH (L3 total cache hits)"},
+        {PAPI_L1_TCA, "PAPI_L1_TCA (L1 total cache accesses)"},
+        {PAPI_L2_TCA, "PAPI_L2_TCA (L2 total cache accesses)"},
+        {PAPI_L3_TCA, "PAPI_L3_TCA (L3 total cache accesses)"},
+        {PAPI_L1_TCR, "PAPI_L1_TCR (L1 total cache reads)"},
+        {PAPI_L2_TCR, "PAPI_L2_TCR (L2 total cache reads)"},
+        {PAPI_L3_TCR, "PAPI_L3_TCR (L3 total cache reads)"},
+        {PAPI_L1_TCW, "PAPI_L1_TCW (L1 total cache writes)"},
+        {PAPI_L2_TCW, "PAPI_L2_TCW (L2 total cache writes)"},
+        {PAPI_L3_TCW, "PAPI_L3_TCW (L3 total cache writes)"},
+        {PAPI_FML_INS, "PAPI_FML_INS (FM ins)"},
+        {PAPI_FAD_INS, "PAPI_FAD_INS (FA ins)"},
+        {PAPI_FDV_INS, "PAPI_FDV_INS (FD ins)"},
+        {PAPI_FSQ_INS, "PAPI_FSQ_INS (FSq ins)"},
+        {PAPI_FNV_INS, "PAPI_FNV_INS (Finv ins)"},
+        {PAPI_FP_OPS, "PAPI_FP_OPS (Floating point operations executed)"},
+        {PAPI_SP_OPS, "PAPI_SP_OPS (Floating point operations executed: optimized to count scaled single precision vector operations)"},
+        {PAPI_DP_OPS, "PAPI_DP_OPS (Floating point operations executed: optimized to count scaled double precision vector operations)"},
+        {PAPI_VEC_SP, "PAPI_VEC_SP (Single precision vector/SIMD instructions)"},
+        {PAPI_VEC_DP, "PAPI_VEC_DP (Double precision vector/SIMD instructions)"},
+        {PAPI_REF_CYC, "PAPI_REF_CYC (Reference clock cycles)"},
+    };
+
+    /* Descriptions of the preset events indexed by the preset number, s.t. a lookup is a single array access */
+    struct PresetDescriptionTable
+    {
+        const char *entries[PAPI_MAX_PRESET_EVENTS] = {};
+
+        constexpr PresetDescriptionTable()
+        {
+            for (auto &preset : PresetDescriptions)
+                entries[preset.code & PAPI_PRESET_AND_MASK] = preset.description;
+        }
+    };
+
+    constexpr PresetDescriptionTable PresetDescriptionsByIndex{};
+
+    /* Get the description of a preset event or "UNKNOWN CODE". Evaluated at compile time for constant codes */
+    constexpr const char *GetPresetDescription(const int eventCode)
+    {
+        if ((eventCode & PAPI_PRESET_MASK) == 0 || (eventCode & PAPI_PRESET_AND_MASK) >= PAPI_MAX_PRESET_EVENTS)
+            return "UNKNOWN CODE";
+
+        const char *description = PresetDescriptionsByIndex.entries[eventCode & PAPI_PRESET_AND_MASK];
+        return description != nullptr ? description : "UNKNOWN CODE";
+    }
+} // namespace PAPIW
+
+/* Metadata of a counted event */
+struct PapiWrapperEventInfo
+{
+    int code;
+    std::string symbol;      // Name of the event, e.g. PAPI_TOT_CYC or perf::CONTEXT-SWITCHES
+    std::string description; // Long description as reported by Papi
+    std::string units;       // Empty for plain counts
+    std::string label;       // "<symbol> (<description>)", followed by " [<units>]" if there are units
+};
+
+/**
+ * Metadata of all counted events
+ *
+ * It is queried once from Papi when the events are known, s.t. printing and exporting only look up
+ * the code in a small flat table and never call Papi.
+ */
+class PapiWrapperEventTable
+{
+private:
+    std::vector<PapiWrapperEventInfo> entries;
+
+public:
+    /* Query the metadata of the events. Entries of events which are already known are kept */
+    void Build(const std::vector<int> &events)
+    {
+        std::vector<PapiWrapperEventInfo> built;
+        for (auto eventCode : events)
+        {
+            auto known = Find(eventCode);
+            built.push_back(known != nullptr ? *known : query(eventCode));
+        }
+        entries.swap(built);
+    }
+
+    /* Get the metadata of an event or nullptr if it is not in the table */
+    const PapiWrapperEventInfo *Find(const int eventCode) const
+    {
+        for (auto &entry : entries)
+            if (entry.code == eventCode)
+                return &entry;
+        return nullptr;
+    }
+
+private:
+    static PapiWrapperEventInfo query(const int eventCode)
+    {
+        PapiWrapperEventInfo entry;
+        entry.code = eventCode;
+
+        if (PapiWrapperBackend::Get().GetEventInfo(eventCode, entry.symbol, entry.description, entry.units) != PAPI_OK)
+        {
+            char name[16];
+            snprintf(name, sizeof(name), "0x%x", eventCode);
+            entry.symbol = name;
+        }
+
+        /* The presets keep their well known descriptions */
+        const char *preset = PAPIW::GetPresetDescription(eventCode);
+        if (strcmp(preset, "UNKNOWN CODE") != 0)
+            entry.label = preset;
+        else if (!entry.description.empty())
+            entry.label = entry.symbol + " (" + entry.description + ")";
+        else
+            entry.label = entry.symbol;
+        if (!entry.units.empty())
+            entry.label += " [" + entry.units + "]";
+        return entry;
+    }
+};
+
+#endif
+#endif
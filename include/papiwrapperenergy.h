@@ -0,0 +1,292 @@
+#ifndef PAPIWRAPPERENERGY
+#define PAPIWRAPPERENERGY
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Root of the powercap sysfs tree. Can be overridden at run time with the environment variable PAPIW_ENERGY_ROOT */
+#ifndef PAPIW_ENERGY_ROOT
+#define PAPIW_ENERGY_ROOT "/sys/class/powercap"
+#endif
+
+/**
+ * Energy of the RAPL domains of the powercap interface, attributed to counting intervals and named regions
+ *
+ * Every socket is a zone intel-rapl:<socket> of the powercap tree, with subzones like core, uncore or dram
+ * in intel-rapl:<socket>:<index>. The energy_uj file of a zone counts microjoules and wraps around at
+ * max_energy_range_uj. Each zone is extended to a 64 bit counter whenever it is read, which is correct as
+ * long as the zone is read at least once per wraparound, i.e. every few minutes at full load.
+ *
+ * The energy is a property of the whole socket, not of a thread. A region is measured from the first thread
+ * which begins it to the last thread which ends it, the intervals from the first Start to the last Stop.
+ * Counters which are only started for a region or for the calibration are not part of the intervals.
+ *
+ * @note Only one instance may be active at a time. Reading energy_uj usually needs root privileges
+ */
+class PapiWrapperEnergy
+{
+public:
+    /* Region id of the intervals from starting to stopping the counters */
+    static constexpr uint64_t IntervalRegion = 0;
+
+    /**
+     * Discover the zones and activate the instance
+     *
+     * @param root Root of the powercap tree, e.g. a fake tree for testing. Defaults to PAPIW_ENERGY_ROOT
+     */
+    explicit PapiWrapperEnergy(const char *root = nullptr)
+    {
+        if (root == nullptr)
+            root = getenv("PAPIW_ENERGY_ROOT");
+        if (root == nullptr)
+            root = PAPIW_ENERGY_ROOT;
+
+        for (auto &socket : listZones(root))
+        {
+            std::string path = std::string(root) + "/" + socket;
+            std::string name = readName(path);
+            addZone(name, path);
+            for (auto &subzone : listZones(path))
+                addZone(name + "/" + readName(path + "/" + subzone), path + "/" + subzone);
+        }
+        names.reserve(zones.size());
+        for (auto &zone : zones)
+            names.push_back(zone.name);
+
+        active = this;
+    }
+
+    ~PapiWrapperEnergy()
+    {
+        /* Another instance may have been activated since */
+        PapiWrapperEnergy *self = this;
+        active.compare_exchange_strong(self, nullptr);
+        for (auto &zone : zones)
+            close(zone.file);
+    }
+
+    /* Names of the readable zones, e.g. package-0 and package-0/dram */
+    const std::vector<std::string> &Zones() const
+    {
+        return names;
+    }
+
+    /* Begin measuring a region of the active instance. Does nothing if no instance is active */
+    static void Begin(const uint64_t region, const char *name = nullptr)
+    {
+        PapiWrapperEnergy *energy = active.load(std::memory_order_acquire);
+        if (energy != nullptr)
+            energy->begin(region, name);
+    }
+
+    /* End measuring a region of the active instance. Does nothing if no instance is active */
+    static void End(const uint64_t region)
+    {
+        PapiWrapperEnergy *energy = active.load(std::memory_order_acquire);
+        if (energy != nullptr)
+            energy->end(region);
+    }
+
+    /* Get the joules of every zone in the order of Zones(), measured in a region or in the intervals. Zero if it was never measured */
+    std::vector<double> GetJoules(const uint64_t region = IntervalRegion)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto entry = regions.find(region);
+        if (entry == regions.end())
+            return std::vector<double>(zones.size(), 0);
+        return joules(entry->second);
+    }
+
+    /* Get the names and joules of all regions except the intervals, in the order they were begun first */
+    std::vector<std::pair<std::string, std::vector<double>>> GetRegionJoules()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::pair<std::string, std::vector<double>>> result;
+        for (auto region : order)
+        {
+            auto &entry = regions[region];
+            result.push_back({entry.name, joules(entry)});
+        }
+        return result;
+    }
+
+    /* Forget the energy measured so far. Regions which are open stay open */
+    void Reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &entry : regions)
+            std::fill(entry.second.energy.begin(), entry.second.energy.end(), 0);
+    }
+
+private:
+    struct Zone
+    {
+        std::string name;
+        int file;
+        long long range; // Microjoules at which energy_uj wraps around, 0 if unknown
+        long long last;  // Last value of energy_uj
+        long long total; // Microjoules since the zone was opened, without wraparounds
+    };
+
+    struct Region
+    {
+        std::string name;
+        int depth = 0;                 // Number of threads inside the region
+        std::vector<long long> start;  // Totals of the zones when the first thread began the region
+        std::vector<long long> energy; // Microjoules per zone
+    };
+
+    inline static std::atomic<PapiWrapperEnergy *> active{nullptr};
+    std::vector<Zone> zones;
+    std::vector<std::string> names;
+    std::map<uint64_t, Region> regions;
+    std::vector<uint64_t> order; // Regions except the intervals in the order they were begun first
+    std::mutex mutex;
+
+    /* Names of the entries intel-rapl:<index> of a directory, sorted by index */
+    static std::vector<std::string> listZones(const std::string &path)
+    {
+        std::vector<std::string> result;
+        DIR *directory = opendir(path.c_str());
+        if (directory == nullptr)
+            return result;
+
+        /* Subzones are named after their zone, e.g. intel-rapl:0:1 in intel-rapl:0 */
+        size_t slash = path.find_last_of('/');
+        std::string parent = slash == std::string::npos ? path : path.substr(slash + 1);
+        std::string prefix = parent.compare(0, 11, "intel-rapl:") == 0 ? parent + ":" : "intel-rapl:";
+        for (dirent *entry = readdir(directory); entry != nullptr; entry = readdir(directory))
+        {
+            std::string name = entry->d_name;
+            if (name.compare(0, prefix.size(), prefix) == 0 && name.find(':', prefix.size()) == std::string::npos)
+                result.push_back(name);
+        }
+        closedir(directory);
+
+        std::sort(result.begin(), result.end(), [&](const std::string &a, const std::string &b)
+                  { return atoi(a.c_str() + prefix.size()) < atoi(b.c_str() + prefix.size()); });
+        return result;
+    }
+
+    /* Read the first line of a file, empty if it is not readable */
+    static std::string readLine(const std::string &path)
+    {
+        char line[256] = {};
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr)
+            return "";
+        if (fgets(line, sizeof(line), file) == nullptr)
+            line[0] = '\0';
+        fclose(file);
+        line[strcspn(line, "\n")] = '\0';
+        return line;
+    }
+
+    /* Name of a zone, e.g. package-0 or dram. The directory name if there is none */
+    static std::string readName(const std::string &path)
+    {
+        std::string name = readLine(path + "/name");
+        return name.empty() ? path.substr(path.find_last_of('/') + 1) : name;
+    }
+
+    /* Add a zone whose energy_uj is readable */
+    void addZone(const std::string &name, const std::string &path)
+    {
+        Zone zone;
+        zone.name = name;
+        zone.file = open((path + "/energy_uj").c_str(), O_RDONLY | O_CLOEXEC);
+        if (zone.file < 0)
+            return;
+
+        zone.range = atoll(readLine(path + "/max_energy_range_uj").c_str());
+        zone.last = read(zone.file);
+        zone.total = 0;
+        if (zone.last < 0)
+        {
+            close(zone.file);
+            return;
+        }
+        zones.push_back(zone);
+    }
+
+    /* Read the current value of an energy_uj file, -1 on failure */
+    static long long read(const int file)
+    {
+        char text[32];
+        ssize_t length = pread(file, text, sizeof(text) - 1, 0);
+        if (length <= 0)
+            return -1;
+        text[length] = '\0';
+        return atoll(text);
+    }
+
+    /* Bring the totals of all zones up to date, counting a smaller value as one wraparound. Without a known range, the delta of a wraparound is unknown and skipped */
+    void sample()
+    {
+        for (auto &zone : zones)
+        {
+            long long now = read(zone.file);
+            if (now < 0)
+                continue;
+            if (now >= zone.last)
+                zone.total += now - zone.last;
+            else if (zone.range > 0)
+                zone.total += now + zone.range - zone.last;
+            zone.last = now;
+        }
+    }
+
+    void begin(const uint64_t region, const char *name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto inserted = regions.insert({region, Region()});
+        Region &entry = inserted.first->second;
+        if (inserted.second)
+        {
+            entry.name = name != nullptr ? name : "";
+            entry.start.resize(zones.size());
+            entry.energy.resize(zones.size());
+            if (region != IntervalRegion)
+                order.push_back(region);
+        }
+        if (entry.depth++ != 0)
+            return;
+
+        sample();
+        for (size_t i = 0; i < zones.size(); i++)
+            entry.start[i] = zones[i].total;
+    }
+
+    void end(const uint64_t region)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto entry = regions.find(region);
+        if (entry == regions.end() || entry->second.depth == 0 || --entry->second.depth != 0)
+            return;
+
+        sample();
+        for (size_t i = 0; i < zones.size(); i++)
+            entry->second.energy[i] += zones[i].total - entry->second.start[i];
+    }
+
+    std::vector<double> joules(const Region &entry)
+    {
+        std::vector<double> result;
+        for (auto microjoules : entry.energy)
+            result.push_back(microjoules * 1e-6);
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef PAPIWRAPPEREVENTSET
+#define PAPIWRAPPEREVENTSET
+
+#include <stddef.h>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include "./papiwrapperutil.h"
+#include "./papiwrapperdescriptions.h"
+
+namespace PAPIW
+{
+    /* Counting mode of an EventSet */
+    enum class Mode
+    {
+        SINGLE,
+        PARALLEL,
+        PARALLEL_PERSISTENT
+    };
+
+    /**
+     * Event set whose events are fixed at compile time
+     *
+     * The position of an event and its description are resolved at compile time, s.t. reading a result
+     * is a plain array access. The counting itself is done by a PapiWrapperSingle or PapiWrapperParallel.
+     *
+     * Example of use:
+     *     PAPIW::EventSet<PAPI_TOT_CYC, PAPI_L3_TCM> counters;
+     *     counters.Start();
+     *     doWork();
+     *     counters.Stop();
+     *     long long misses = counters.GetResult<PAPI_L3_TCM>();
+     *
+     * @note With NOPAPIW, all operations are No-ops and all results are zero
+     */
+    template <int... Codes>
+    class EventSet
+    {
+    public:
+        static constexpr size_t Size = sizeof...(Codes);
+        static constexpr std::array<int, Size> Events{{Codes...}};
+
+        /* Position of an event in the set. Fails to compile if the event is not part of the set */
+        template <int Code>
+        static constexpr size_t IndexOf()
+        {
+            constexpr size_t index = find(Code);
+            static_assert(index < Size, "The event is not part of the EventSet");
+            return index;
+        }
+
+#if !defined(NOPAPIW)
+        static constexpr std::array<const char *, Size> Descriptions{{GetPresetDescription(Codes)...}};
+#endif
+
+    private:
+        std::array<long long, Size> values{};
+#if !defined(NOPAPIW)
+        std::unique_ptr<PapiWrapper> wrapper;
+        std::array<int, Size> positions{}; // Position of every event in the wrapper or -1 if it could not be added
+#endif
+
+        static constexpr size_t find(const int code)
+        {
+            for (size_t i = 0; i < Size; i++)
+                if (Events[i] == code)
+                    return i;
+            return Size;
+        }
+
+    public:
+        /**
+         * @param mode Count on the calling thread only or on every thread of the omp team
+         * @warning Exits with an error if called in a parallel region
+         */
+        EventSet(const Mode mode = Mode::SINGLE)
+        {
+#if !defined(NOPAPIW)
+#ifdef _OPENMP
+            if (mode == Mode::PARALLEL)
+                wrapper.reset(new PapiWrapperParallel());
+            else if (mode == Mode::PARALLEL_PERSISTENT)
+                wrapper.reset(new PapiWrapperParallel(true));
+            else
+#endif
+                wrapper.reset(new PapiWrapperSingle());
+            wrapper->Init(Codes...);
+
+            /* Events which are not available are dropped by the wrapper, so their position is looked up once */
+            auto &added = wrapper->GetEvents();
+            for (size_t i = 0; i < Size; i++)
+            {
+                auto position = std::find(added.begin(), added.end(), Events[i]);
+                positions[i] = position == added.end() ? -1 : position - added.begin();
+            }
+#else
+            (void)mode;
+#endif
+        }
+
+        /* Start the counters */
+        void Start()
+        {
+#if !defined(NOPAPIW)
+            wrapper->Start();
+#endif
+        }
+
+        /* Stop the counters and update the results */
+        void Stop()
+        {
+#if !defined(NOPAPIW)
+            wrapper->Stop();
+            update();
+#endif
+        }
+
+        /* Set the results to zero */
+        void Reset()
+        {
+#if !defined(NOPAPIW)
+            wrapper->Reset();
+#endif
+            values.fill(0);
+        }
+
+        /* Get the result of an event. Zero if the event is not available on the system */
+        template <int Code>
+        long long GetResult() const
+        {
+            return values[IndexOf<Code>()];
+        }
+
+        /* Get the results of all events in the order of the template arguments */
+        const std::array<long long, Size> &GetResults() const
+        {
+            return values;
+        }
+
+        /* Print the results */
+        void Print()
+        {
+#if !defined(NOPAPIW)
+            wrapper->Print();
+#endif
+        }
+
+    private:
+#if !defined(NOPAPIW)
+        /* Copy the results of the wrapper into the fixed positions */
+        void update()
+        {
+            long long results[Size + 1];
+            wrapper->GetResults(results);
+            for (size_t i = 0; i < Size; i++)
+                values[i] = positions[i] == -1 ? 0 : results[positions[i]];
+        }
+#endif
+    };
+} // namespace PAPIW
+
+#endif
@@ -0,0 +1,323 @@
+#ifndef PAPIWRAPPEREXPORT
+#define PAPIWRAPPEREXPORT
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/* Initial size of the buffer the results are formatted into */
+#ifndef PAPIW_EXPORT_BUFFER_SIZE
+#define PAPIW_EXPORT_BUFFER_SIZE (64 * 1024)
+#endif
+
+namespace PAPIW
+{
+    /* Machine readable output formats */
+    enum class Format
+    {
+        JSON,
+        CSV,
+        PROMETHEUS
+    };
+} // namespace PAPIW
+
+/**
+ * Results handed to the exporters
+ *
+ * The instance is reused for every export, s.t. the vectors only allocate when the results grow.
+ */
+struct PapiWrapperReport
+{
+    const char *mode = "";    // "single" or "parallel"
+    bool multiplexed = false; // If true, the values are estimates scaled to enabledTime
+    long long enabledTime = 0;
+    std::vector<int> events;
+    std::vector<std::string> names;
+    std::vector<long long> totals;
+    int threads = 0;
+    std::vector<long long> threadValues; // threads values per event
+    std::vector<const char *> regionNames;
+    std::vector<long long> regionIntervals;
+    std::vector<long long> regionValues; // One value per event for every region
+};
+
+/**
+ * Text buffer which is allocated once and reused
+ *
+ * It only grows if a report does not fit, s.t. repeated exports of the same results never allocate.
+ */
+class PapiWrapperBuffer
+{
+private:
+    std::vector<char> data;
+    size_t used = 0;
+
+public:
+    PapiWrapperBuffer() : data(PAPIW_EXPORT_BUFFER_SIZE) {}
+
+    void Clear()
+    {
+        used = 0;
+        data[0] = '\0';
+    }
+
+    /* Append formatted text */
+    __attribute__((format(printf, 2, 3))) void Append(const char *format, ...)
+    {
+        while (true)
+        {
+            va_list args;
+            va_start(args, format);
+            int length = vsnprintf(data.data() + used, data.size() - used, format, args);
+            va_end(args);
+            if (length < 0)
+                return;
+            if (used + length < data.size())
+            {
+                used += length;
+                return;
+            }
+            data.resize(2 * (used + length + 1));
+        }
+    }
+
+    /* Append a string as JSON string content, escaping the characters listed in special with a backslash */
+    void AppendEscaped(const char *text, const char *special)
+    {
+        for (; *text != '\0'; text++)
+        {
+            if (*text == '\n')
+                Append("\\n");
+            else if (static_cast<unsigned char>(*text) < 0x20)
+                Append("\\u%04x", *text);
+            else
+            {
+                for (const char *c = special; *c != '\0'; c++)
+                    if (*c == *text)
+                        Append("\\");
+                Append("%c", *text);
+            }
+        }
+    }
+
+    /* Append a string as Prometheus label value, which only escapes backslash, double quote and line feed */
+    void AppendLabel(const char *text)
+    {
+        for (; *text != '\0'; text++)
+        {
+            if (*text == '\n')
+                Append("\\n");
+            else if (*text == '"' || *text == '\\')
+                Append("\\%c", *text);
+            else
+                Append("%c", *text);
+        }
+    }
+
+    /* Append a string as quoted CSV field, doubling the quotes inside */
+    void AppendQuoted(const char *text)
+    {
+        Append("\"");
+        for (; *text != '\0'; text++)
+        {
+            if (*text == '"')
+                Append("\"");
+            Append("%c", *text);
+        }
+        Append("\"");
+    }
+
+    const char *Data() const
+    {
+        return data.data();
+    }
+
+    size_t Size() const
+    {
+        return used;
+    }
+};
+
+class PapiWrapperExporter;
+
+/**
+ * Export state of one instance, allocated on its first export s.t. per thread instances stay small
+ */
+struct PapiWrapperOutput
+{
+    PapiWrapperReport report;
+    PapiWrapperBuffer buffer;
+    std::vector<std::pair<PapiWrapperExporter *, std::string>> printExporters; // Exporters run by Print and their files
+};
+
+/**
+ * Formats results into a machine readable text
+ */
+class PapiWrapperExporter
+{
+public:
+    virtual ~PapiWrapperExporter() {}
+
+    /* Format the report, appending to out */
+    virtual void Format(const PapiWrapperReport &report, PapiWrapperBuffer &out) = 0;
+
+    /* Exporter of the given format */
+    static PapiWrapperExporter &Get(const PAPIW::Format format);
+};
+
+/**
+ * One JSON object holding the totals, the values of every thread and the regions:
+ * {"mode": ..., "events": [{"name": ..., "code": ..., "total": ..., "threads": [...]}], "regions": [...]}
+ */
+class PapiWrapperJsonExporter : public PapiWrapperExporter
+{
+public:
+    void Format(const PapiWrapperReport &report, PapiWrapperBuffer &out) override
+    {
+        int count = report.events.size();
+        out.Append("{\"mode\":\"%s\",\"multiplexed\":%s,\"enabled_time_ns\":%lld,\"events\":[",
+                   report.mode, report.multiplexed ? "true" : "false", report.enabledTime);
+        for (int i = 0; i < count; i++)
+        {
+            out.Append("%s{\"name\":\"", i == 0 ? "" : ",");
+            out.AppendEscaped(report.names[i].c_str(), "\"\\");
+            out.Append("\",\"code\":%d,\"total\":%lld,\"threads\":[", report.events[i], report.totals[i]);
+            for (int thread = 0; thread < report.threads; thread++)
+                out.Append("%s%lld", thread == 0 ? "" : ",", report.threadValues[i * report.threads + thread]);
+            out.Append("]}");
+        }
+
+        out.Append("],\"regions\":[");
+        int regions = report.regionNames.size();
+        for (int region = 0; region < regions; region++)
+        {
+            out.Append("%s{\"name\":\"", region == 0 ? "" : ",");
+            out.AppendEscaped(report.regionNames[region], "\"\\");
+            out.Append("\",\"intervals\":%lld,\"values\":[", report.regionIntervals[region]);
+            for (int i = 0; i < count; i++)
+                out.Append("%s%lld", i == 0 ? "" : ",", report.regionValues[region * count + i]);
+            out.Append("]}");
+        }
+        out.Append("]}\n");
+    }
+};
+
+/**
+ * One row for the totals, every thread and every region:
+ * scope,name,intervals,<event names...>
+ */
+class PapiWrapperCsvExporter : public PapiWrapperExporter
+{
+public:
+    void Format(const PapiWrapperReport &report, PapiWrapperBuffer &out) override
+    {
+        int count = report.events.size();
+        out.Append("scope,name,intervals");
+        for (auto &name : report.names)
+        {
+            out.Append(",");
+            out.AppendQuoted(name.c_str());
+        }
+        out.Append("\n");
+
+        out.Append("total,%s,", report.mode);
+        for (int i = 0; i < count; i++)
+            out.Append(",%lld", report.totals[i]);
+        out.Append("\n");
+
+        for (int thread = 0; thread < report.threads; thread++)
+        {
+            out.Append("thread,%d,", thread);
+            for (int i = 0; i < count; i++)
+                out.Append(",%lld", report.threadValues[i * report.threads + thread]);
+            out.Append("\n");
+        }
+
+        int regions = report.regionNames.size();
+        for (int region = 0; region < regions; region++)
+        {
+            out.Append("region,");
+            out.AppendQuoted(report.regionNames[region]);
+            out.Append(",%lld", report.regionIntervals[region]);
+            for (int i = 0; i < count; i++)
+                out.Append(",%lld", report.regionValues[region * count + i]);
+            out.Append("\n");
+        }
+    }
+};
+
+/**
+ * Prometheus text exposition format, e.g. for the textfile collector of the node exporter
+ */
+class PapiWrapperPrometheusExporter : public PapiWrapperExporter
+{
+public:
+    void Format(const PapiWrapperReport &report, PapiWrapperBuffer &out) override
+    {
+        int count = report.events.size();
+        out.Append("# HELP papiw_events_total Hardware events counted by PAPIW\n# TYPE papiw_events_total counter\n");
+        for (int i = 0; i < count; i++)
+        {
+            out.Append("papiw_events_total{event=\"");
+            out.AppendLabel(report.names[i].c_str());
+            out.Append("\"} %lld\n", report.totals[i]);
+        }
+
+        out.Append("# HELP papiw_thread_events_total Hardware events counted by PAPIW per thread\n# TYPE papiw_thread_events_total counter\n");
+        for (int i = 0; i < count; i++)
+            for (int thread = 0; thread < report.threads; thread++)
+            {
+                out.Append("papiw_thread_events_total{event=\"");
+                out.AppendLabel(report.names[i].c_str());
+                out.Append("\",thread=\"%d\"} %lld\n", thread, report.threadValues[i * report.threads + thread]);
+            }
+
+        int regions = report.regionNames.size();
+        if (regions != 0)
+        {
+            out.Append("# HELP papiw_region_intervals_total Measured intervals of a PAPIW region\n# TYPE papiw_region_intervals_total counter\n");
+            for (int region = 0; region < regions; region++)
+            {
+                out.Append("papiw_region_intervals_total{region=\"");
+                out.AppendLabel(report.regionNames[region]);
+                out.Append("\"} %lld\n", report.regionIntervals[region]);
+            }
+
+            out.Append("# HELP papiw_region_events_total Hardware events counted by PAPIW per region\n# TYPE papiw_region_events_total counter\n");
+            for (int region = 0; region < regions; region++)
+                for (int i = 0; i < count; i++)
+                {
+                    out.Append("papiw_region_events_total{event=\"");
+                    out.AppendLabel(report.names[i].c_str());
+                    out.Append("\",region=\"");
+                    out.AppendLabel(report.regionNames[region]);
+                    out.Append("\"} %lld\n", report.regionValues[region * count + i]);
+                }
+        }
+
+        if (report.multiplexed)
+            out.Append("# HELP papiw_enabled_time_nanoseconds_total Time the multiplexed counters were enabled\n"
+                       "# TYPE papiw_enabled_time_nanoseconds_total counter\npapiw_enabled_time_nanoseconds_total %lld\n",
+                       report.enabledTime);
+    }
+};
+
+inline PapiWrapperExporter &PapiWrapperExporter::Get(const PAPIW::Format format)
+{
+    static PapiWrapperJsonExporter json;
+    static PapiWrapperCsvExporter csv;
+    static PapiWrapperPrometheusExporter prometheus;
+    switch (format)
+    {
+    case PAPIW::Format::JSON:
+        return json;
+    case PAPIW::Format::CSV:
+        return csv;
+    default:
+        return prometheus;
+    }
+}
+
+#endif
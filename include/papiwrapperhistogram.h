@@ -0,0 +1,266 @@
+#ifndef PAPIWRAPPERHISTOGRAM
+#define PAPIWRAPPERHISTOGRAM
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Sub-bucket bits of the histograms. Every power of two is split into 2^bits buckets, i.e. the relative error is below 2^-bits */
+#ifndef PAPIW_HISTOGRAM_PRECISION
+#define PAPIW_HISTOGRAM_PRECISION 5
+#endif
+
+/**
+ * Histogram of non-negative 64 bit values with logarithmic buckets of constant relative width
+ *
+ * Values below 2^(bits+1) are counted exactly. Above, every power of two is split into 2^bits buckets,
+ * as in an HDR histogram. The memory is fixed, (65 - bits) * 2^bits counters, and recording a value is
+ * a count leading zeros and an increment. Histograms are merged by adding the counters.
+ */
+class PapiWrapperHistogram
+{
+public:
+    static int const precision = PAPIW_HISTOGRAM_PRECISION;
+    static_assert(precision >= 1 && precision <= 16, "PAPIW_HISTOGRAM_PRECISION must be between 1 and 16");
+
+    PapiWrapperHistogram() : counts(bucketCount, 0) {}
+
+    /* Count a value. Negative values, e.g. from rounding of scaled estimates, are counted as 0 */
+    void Record(const long long value)
+    {
+        uint64_t v = value > 0 ? value : 0;
+        counts[index(v)]++;
+        total++;
+        maximum = std::max(maximum, v);
+    }
+
+    /* Add the counts of another histogram */
+    void Merge(const PapiWrapperHistogram &other)
+    {
+        for (size_t i = 0; i < bucketCount; i++)
+            counts[i] += other.counts[i];
+        total += other.total;
+        maximum = std::max(maximum, other.maximum);
+    }
+
+    /**
+     * Get the value below or at which a fraction of the recorded values lie
+     *
+     * @param percentile Percentile between 0 and 100, e.g. 99.9
+     * @return The highest value of the bucket the percentile falls into, at most the maximum. 0 if nothing was recorded
+     */
+    uint64_t Percentile(const double percentile) const
+    {
+        if (total == 0)
+            return 0;
+
+        double clamped = std::min(std::max(percentile, 0.0), 100.0);
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped / 100 * total + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucketCount; i++)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+                return std::min(highest(i), maximum);
+        }
+        return maximum;
+    }
+
+    /* Number of recorded values */
+    uint64_t Count() const
+    {
+        return total;
+    }
+
+    /* Largest recorded value, exact */
+    uint64_t Max() const
+    {
+        return maximum;
+    }
+
+    void Reset()
+    {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        maximum = 0;
+    }
+
+private:
+    static uint64_t const subBuckets = 1ull << precision;
+    static size_t const bucketCount = (65 - precision) * subBuckets;
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t maximum = 0;
+
+    /* Bucket b > 0 holds the values (s << b) to ((s + 1) << b) - 1 with s in [2^bits, 2^(bits+1)) at index b * 2^bits + s */
+    static size_t index(const uint64_t value)
+    {
+        int magnitude = value == 0 ? 0 : 63 - __builtin_clzll(value);
+        int shift = std::max(magnitude - precision, 0);
+        return shift * subBuckets + (value >> shift);
+    }
+
+    static uint64_t highest(const size_t index)
+    {
+        int shift = index < 2 * subBuckets ? 0 : index / subBuckets - 1;
+        uint64_t sub = index - shift * subBuckets;
+        return ((sub + 1) << shift) - 1;
+    }
+};
+
+/**
+ * Distribution of the counter values of every interval and of every region instance
+ *
+ * Every thread records into histograms of its own, which are only merged when the distribution is reported.
+ * Recording takes the lock only when a thread records for the first time or enters a region it has not seen before.
+ * The values are raw deltas, the calibrated overhead is not subtracted. Calibration and the counters started by
+ * a region are not recorded as intervals.
+ *
+ * @note Only one instance may be active at a time. Report and reset it only while no counters are running
+ */
+class PapiWrapperDistribution
+{
+public:
+    /* Region id of the intervals from starting to stopping the counters */
+    static constexpr uint64_t IntervalRegion = 0;
+
+    /* Histograms of every event of one region */
+    struct Region
+    {
+        uint64_t id;
+        std::string name;
+        std::vector<PapiWrapperHistogram> events;
+    };
+
+    /* @param eventCount Number of counted events */
+    explicit PapiWrapperDistribution(const int eventCount) : generation(++activeGeneration), eventCount(eventCount)
+    {
+        active = this;
+    }
+
+    ~PapiWrapperDistribution()
+    {
+        /* Another instance may have been activated since */
+        PapiWrapperDistribution *self = this;
+        active.compare_exchange_strong(self, nullptr);
+    }
+
+    /**
+     * Record the values of an interval or region instance of the calling thread. Does nothing if no instance is active
+     *
+     * @param region Hash of the region name or IntervalRegion
+     * @param name Name of the region, nullptr for the intervals
+     * @param values count counter values
+     * @param base If not nullptr, the values at the begin of the interval, which are subtracted
+     */
+    static void Record(const uint64_t region, const char *name, const long long *values, const int count, const long long *base = nullptr)
+    {
+        PapiWrapperDistribution *distribution = active.load(std::memory_order_acquire);
+        if (distribution != nullptr)
+            distribution->record(region, name, values, count, base);
+    }
+
+    /* Merge the histograms of all threads. The intervals come first, the regions follow in the order they were first recorded */
+    std::vector<Region> Merge()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<Region> result;
+        std::map<uint64_t, size_t> positions;
+        for (auto region : order)
+        {
+            positions[region] = result.size();
+            result.push_back({region, names[region], std::vector<PapiWrapperHistogram>(eventCount)});
+        }
+        for (auto &thread : threads)
+            for (auto &entry : thread->regions)
+            {
+                auto &merged = result[positions[entry.first]].events;
+                for (int i = 0; i < eventCount; i++)
+                    merged[i].Merge(entry.second[i]);
+            }
+        return result;
+    }
+
+    /* Map the values of the following records to events, e.g. the events of one of multiple passes. nullptr for the identity */
+    void SetColumns(const std::vector<int> *columns)
+    {
+        this->columns = columns;
+    }
+
+    /* Forget the recorded values of all threads */
+    void Reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &thread : threads)
+            for (auto &entry : thread->regions)
+                for (auto &histogram : entry.second)
+                    histogram.Reset();
+    }
+
+private:
+    struct Thread
+    {
+        std::unordered_map<uint64_t, std::vector<PapiWrapperHistogram>> regions;
+    };
+
+    /* Histograms of the calling thread in the instance of a generation. Zero initialized as thread local */
+    struct Local
+    {
+        uint64_t generation;
+        Thread *thread;
+    };
+
+    inline static std::atomic<PapiWrapperDistribution *> active{nullptr};
+    inline static std::atomic<uint64_t> activeGeneration{0};
+    inline static thread_local Local local;
+
+    const uint64_t generation;
+    const int eventCount;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Thread>> threads; // Owned here s.t. the histograms outlive the threads
+    std::map<uint64_t, std::string> names;
+    std::vector<uint64_t> order;
+    const std::vector<int> *columns = nullptr; // Event of every recorded value
+
+    void record(const uint64_t region, const char *name, const long long *values, const int count, const long long *base)
+    {
+        if (local.generation != generation)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.emplace_back(new Thread());
+            local.thread = threads.back().get();
+            local.generation = generation;
+        }
+
+        auto entry = local.thread->regions.find(region);
+        if (entry == local.thread->regions.end())
+            entry = addRegion(region, name);
+
+        auto &histograms = entry->second;
+        int known = std::min(count, columns != nullptr ? static_cast<int>(columns->size()) : eventCount);
+        for (int i = 0; i < known; i++)
+        {
+            int event = columns != nullptr ? (*columns)[i] : i;
+            if (event < eventCount)
+                histograms[event].Record(base == nullptr ? values[i] : values[i] - base[i]);
+        }
+    }
+
+    /* Add the histograms of a region to the calling thread and remember its name */
+    std::unordered_map<uint64_t, std::vector<PapiWrapperHistogram>>::iterator addRegion(const uint64_t region, const char *name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (names.insert({region, region == IntervalRegion ? "interval" : name != nullptr ? name : ""}).second)
+            order.insert(region == IntervalRegion ? order.begin() : order.end(), region);
+        return local.thread->regions.emplace(region, std::vector<PapiWrapperHistogram>(eventCount)).first;
+    }
+};
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef PAPIWRAPPERMETRICS
+#define PAPIWRAPPERMETRICS
+
+#include <math.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+/**
+ * A value derived from counted events and the measured time
+ *
+ * Example of a user defined metric:
+ *     PapiWrapperMetric loadsPerStore{"LD_PER_ST", "Loads per store", {PAPI_LD_INS, PAPI_SR_INS},
+ *                                     [](const double *values, double, double) { return values[0] / values[1]; }};
+ */
+struct PapiWrapperMetric
+{
+    std::string name;
+    std::string description;
+    std::vector<int> events; // Events the formula needs, in the order they are passed to it
+
+    /* Computes the metric from the values of events, the real and the virtual time in seconds */
+    std::function<double(const double *values, double realSeconds, double virtSeconds)> formula;
+
+    /* Metric computed as scale * numerator / denominator */
+    static PapiWrapperMetric Ratio(const char *name, const char *description, const int numerator, const int denominator, const double scale = 1)
+    {
+        return {name, description, {numerator, denominator},
+                [scale](const double *values, double, double) { return scale * values[0] / values[1]; }};
+    }
+
+    /* Metric computed as scale * event per second of real time */
+    static PapiWrapperMetric Rate(const char *name, const char *description, const int event, const double scale = 1)
+    {
+        return {name, description, {event},
+                [scale](const double *values, double realSeconds, double) { return scale * values[0] / realSeconds; }};
+    }
+};
+
+/**
+ * The metrics which are computed for a set of events
+ *
+ * Metrics are only accepted if all their events are counted. The position of every event is looked up
+ * once, s.t. computing a metric only gathers the values and calls the formula.
+ */
+class PapiWrapperMetrics
+{
+private:
+    std::vector<PapiWrapperMetric> metrics;
+    std::vector<std::vector<int>> indices; // Position of every event of a metric in the counted events
+    std::vector<double> scratch;
+
+public:
+    /* Add a metric. Returns false if not all its events are counted */
+    bool Add(const PapiWrapperMetric &metric, const std::vector<int> &events)
+    {
+        std::vector<int> positions;
+        for (auto eventCode : metric.events)
+        {
+            auto position = std::find(events.begin(), events.end(), eventCode);
+            if (position == events.end())
+                return false;
+            positions.push_back(position - events.begin());
+        }
+
+        scratch.resize(std::max(scratch.size(), positions.size()));
+
+        /* A metric with the same name is replaced */
+        for (size_t i = 0; i < metrics.size(); i++)
+            if (metrics[i].name == metric.name)
+            {
+                metrics[i] = metric;
+                indices[i] = positions;
+                return true;
+            }
+
+        metrics.push_back(metric);
+        indices.push_back(positions);
+        return true;
+    }
+
+    /* Add every metric of a catalogue whose events are counted */
+    void AddAvailable(const std::vector<PapiWrapperMetric> &catalogue, const std::vector<int> &events)
+    {
+        for (auto &metric : catalogue)
+            Add(metric, events);
+    }
+
+    /* Number of metrics */
+    int Size() const
+    {
+        return metrics.size();
+    }
+
+    /* Get a metric */
+    const PapiWrapperMetric &Get(const int metric) const
+    {
+        return metrics[metric];
+    }
+
+    /* Get the position of a metric by its name or -1 if it is unknown */
+    int Find(const std::string &name) const
+    {
+        for (size_t i = 0; i < metrics.size(); i++)
+            if (metrics[i].name == name)
+                return i;
+        return -1;
+    }
+
+    /**
+     * Compute a metric
+     *
+     * @param values The values of all counted events
+     * @param realNs Nanoseconds of wall clock time the events were counted
+     * @param virtNs Nanoseconds of cpu time the events were counted
+     * @return The value of the metric or NaN if it is undefined, e.g. for a zero denominator
+     */
+    double Compute(const int metric, const long long *values, const long long realNs, const long long virtNs)
+    {
+        auto &positions = indices[metric];
+        for (size_t i = 0; i < positions.size(); i++)
+            scratch[i] = values[positions[i]];
+
+        double value = metrics[metric].formula(scratch.data(), realNs * 1e-9, virtNs * 1e-9);
+        return isfinite(value) ? value : NAN;
+    }
+};
+
+#ifndef NOPAPIW
+#include "./papiwrapperpapi.h"
+
+/* Bytes transferred per last level cache miss */
+#ifndef PAPIW_MEMORY_LINE_SIZE
+#define PAPIW_MEMORY_LINE_SIZE 64
+#endif
+
+/* The standard metrics. They are computed automatically whenever all their events are counted */
+inline const std::vector<PapiWrapperMetric> &PapiWrapperMetricCatalogue()
+{
+    static const std::vector<PapiWrapperMetric> catalogue = {
+        PapiWrapperMetric::Ratio("IPC", "Instructions per cycle", PAPI_TOT_INS, PAPI_TOT_CYC),
+        PapiWrapperMetric::Ratio("CPI", "Cycles per instruction", PAPI_TOT_CYC, PAPI_TOT_INS),
+        PapiWrapperMetric::Ratio("L1_DMR", "L1 data cache miss ratio", PAPI_L1_DCM, PAPI_L1_DCA),
+        PapiWrapperMetric::Ratio("L2_MR", "L2 cache miss ratio", PAPI_L2_TCM, PAPI_L2_TCA),
+        PapiWrapperMetric::Ratio("L2_DMR", "L2 data cache miss ratio", PAPI_L2_DCM, PAPI_L2_DCA),
+        PapiWrapperMetric::Ratio("L3_MR", "L3 cache miss ratio", PAPI_L3_TCM, PAPI_L3_TCA),
+        PapiWrapperMetric::Ratio("BR_MR", "Branch misprediction ratio", PAPI_BR_MSP, PAPI_BR_CN),
+        PapiWrapperMetric::Ratio("TLB_DM_PKI", "Data TLB misses per 1000 instructions", PAPI_TLB_DM, PAPI_TOT_INS, 1000),
+        PapiWrapperMetric::Ratio("L3_BPC", "Bytes from memory per cycle (L3 misses times the line size)", PAPI_L3_TCM, PAPI_TOT_CYC, PAPIW_MEMORY_LINE_SIZE),
+        PapiWrapperMetric::Ratio("FLOPS_PER_CYC", "Floating point operations per cycle", PAPI_FP_OPS, PAPI_TOT_CYC),
+        PapiWrapperMetric::Rate("MIPS", "Million instructions per second", PAPI_TOT_INS, 1e-6),
+        PapiWrapperMetric::Rate("FLOPS", "Floating point operations per second", PAPI_FP_OPS),
+        PapiWrapperMetric::Rate("SP_FLOPS", "Single precision floating point operations per second", PAPI_SP_OPS),
+        PapiWrapperMetric::Rate("DP_FLOPS", "Double precision floating point operations per second", PAPI_DP_OPS),
+        PapiWrapperMetric::Rate("L3_BW", "Bytes from memory per second (L3 misses times the line size)", PAPI_L3_TCM, PAPIW_MEMORY_LINE_SIZE),
+        {"CPU_UTIL", "Cpu time per wall clock time, i.e. the average number of busy threads", {},
+         [](const double *, double realSeconds, double virtSeconds) { return virtSeconds / realSeconds; }},
+    };
+    return catalogue;
+}
+#endif
+
+#endif
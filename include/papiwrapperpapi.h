@@ -0,0 +1,150 @@
+#ifndef PAPIWRAPPERPAPI
+#define PAPIWRAPPERPAPI
+#ifndef NOPAPIW
+
+#ifndef PAPIW_PERF_EVENT
+#include <papi.h>
+#else
+/**
+ * The part of papi.h PapiWrapper depends on, for builds which count with perf_event_open instead of libpapi
+ *
+ * All values match papi.h, s.t. code written against Papi compiles unchanged and event codes are
+ * interchangeable between both builds.
+ */
+
+/* Return codes */
+#define PAPI_OK 0
+#define PAPI_EINVAL -1
+#define PAPI_ENOMEM -2
+#define PAPI_ESYS -3
+#define PAPI_ECMP -4
+#define PAPI_ENOEVNT -7
+#define PAPI_ECNFLCT -8
+#define PAPI_ENOTRUN -9
+#define PAPI_EISRUN -10
+#define PAPI_ENOEVST -11
+#define PAPI_EPERM -15
+#define PAPI_ENOSUPP -18
+
+#define PAPI_NULL -1
+#define PAPI_PRESET_MASK ((int)0x80000000)
+#define PAPI_NATIVE_MASK ((int)0x40000000)
+#define PAPI_PRESET_AND_MASK 0x7FFFFFFF
+#define PAPI_MAX_PRESET_EVENTS 128
+#define PAPI_MAX_STR_LEN 128
+
+typedef void (*PAPI_overflow_handler_t)(int EventSet, void *address, long long overflow_vector, void *context);
+
+/* Preset events */
+#define PAPI_L1_DCM (PAPI_PRESET_MASK | 0)
+#define PAPI_L1_ICM (PAPI_PRESET_MASK | 1)
+#define PAPI_L2_DCM (PAPI_PRESET_MASK | 2)
+#define PAPI_L2_ICM (PAPI_PRESET_MASK | 3)
+#define PAPI_L3_DCM (PAPI_PRESET_MASK | 4)
+#define PAPI_L3_ICM (PAPI_PRESET_MASK | 5)
+#define PAPI_L1_TCM (PAPI_PRESET_MASK | 6)
+#define PAPI_L2_TCM (PAPI_PRESET_MASK | 7)
+#define PAPI_L3_TCM (PAPI_PRESET_MASK | 8)
+#define PAPI_CA_SNP (PAPI_PRESET_MASK | 9)
+#define PAPI_CA_SHR (PAPI_PRESET_MASK | 10)
+#define PAPI_CA_CLN (PAPI_PRESET_MASK | 11)
+#define PAPI_CA_INV (PAPI_PRESET_MASK | 12)
+#define PAPI_CA_ITV (PAPI_PRESET_MASK | 13)
+#define PAPI_L3_LDM (PAPI_PRESET_MASK | 14)
+#define PAPI_L3_STM (PAPI_PRESET_MASK | 15)
+#define PAPI_BRU_IDL (PAPI_PRESET_MASK | 16)
+#define PAPI_FXU_IDL (PAPI_PRESET_MASK | 17)
+#define PAPI_FPU_IDL (PAPI_PRESET_MASK | 18)
+#define PAPI_LSU_IDL (PAPI_PRESET_MASK | 19)
+#define PAPI_TLB_DM (PAPI_PRESET_MASK | 20)
+#define PAPI_TLB_IM (PAPI_PRESET_MASK | 21)
+#define PAPI_TLB_TL (PAPI_PRESET_MASK | 22)
+#define PAPI_L1_LDM (PAPI_PRESET_MASK | 23)
+#define PAPI_L1_STM (PAPI_PRESET_MASK | 24)
+#define PAPI_L2_LDM (PAPI_PRESET_MASK | 25)
+#define PAPI_L2_STM (PAPI_PRESET_MASK | 26)
+#define PAPI_BTAC_M (PAPI_PRESET_MASK | 27)
+#define PAPI_PRF_DM (PAPI_PRESET_MASK | 28)
+#define PAPI_L3_DCH (PAPI_PRESET_MASK | 29)
+#define PAPI_TLB_SD (PAPI_PRESET_MASK | 30)
+#define PAPI_CSR_FAL (PAPI_PRESET_MASK | 31)
+#define PAPI_CSR_SUC (PAPI_PRESET_MASK | 32)
+#define PAPI_CSR_TOT (PAPI_PRESET_MASK | 33)
+#define PAPI_MEM_SCY (PAPI_PRESET_MASK | 34)
+#define PAPI_MEM_RCY (PAPI_PRESET_MASK | 35)
+#define PAPI_MEM_WCY (PAPI_PRESET_MASK | 36)
+#define PAPI_STL_ICY (PAPI_PRESET_MASK | 37)
+#define PAPI_FUL_ICY (PAPI_PRESET_MASK | 38)
+#define PAPI_STL_CCY (PAPI_PRESET_MASK | 39)
+#define PAPI_FUL_CCY (PAPI_PRESET_MASK | 40)
+#define PAPI_HW_INT (PAPI_PRESET_MASK | 41)
+#define PAPI_BR_UCN (PAPI_PRESET_MASK | 42)
+#define PAPI_BR_CN (PAPI_PRESET_MASK | 43)
+#define PAPI_BR_TKN (PAPI_PRESET_MASK | 44)
+#define PAPI_BR_NTK (PAPI_PRESET_MASK | 45)
+#define PAPI_BR_MSP (PAPI_PRESET_MASK | 46)
+#define PAPI_BR_PRC (PAPI_PRESET_MASK | 47)
+#define PAPI_FMA_INS (PAPI_PRESET_MASK | 48)
+#define PAPI_TOT_IIS (PAPI_PRESET_MASK | 49)
+#define PAPI_TOT_INS (PAPI_PRESET_MASK | 50)
+#define PAPI_INT_INS (PAPI_PRESET_MASK | 51)
+#define PAPI_FP_INS (PAPI_PRESET_MASK | 52)
+#define PAPI_LD_INS (PAPI_PRESET_MASK | 53)
+#define PAPI_SR_INS (PAPI_PRESET_MASK | 54)
+#define PAPI_BR_INS (PAPI_PRESET_MASK | 55)
+#define PAPI_VEC_INS (PAPI_PRESET_MASK | 56)
+#define PAPI_RES_STL (PAPI_PRESET_MASK | 57)
+#define PAPI_FP_STAL (PAPI_PRESET_MASK | 58)
+#define PAPI_TOT_CYC (PAPI_PRESET_MASK | 59)
+#define PAPI_LST_INS (PAPI_PRESET_MASK | 60)
+#define PAPI_SYC_INS (PAPI_PRESET_MASK | 61)
+#define PAPI_L1_DCH (PAPI_PRESET_MASK | 62)
+#define PAPI_L2_DCH (PAPI_PRESET_MASK | 63)
+#define PAPI_L1_DCA (PAPI_PRESET_MASK | 64)
+#define PAPI_L2_DCA (PAPI_PRESET_MASK | 65)
+#define PAPI_L3_DCA (PAPI_PRESET_MASK | 66)
+#define PAPI_L1_DCR (PAPI_PRESET_MASK | 67)
+#define PAPI_L2_DCR (PAPI_PRESET_MASK | 68)
+#define PAPI_L3_DCR (PAPI_PRESET_MASK | 69)
+#define PAPI_L1_DCW (PAPI_PRESET_MASK | 70)
+#define PAPI_L2_DCW (PAPI_PRESET_MASK | 71)
+#define PAPI_L3_DCW (PAPI_PRESET_MASK | 72)
+#define PAPI_L1_ICH (PAPI_PRESET_MASK | 73)
+#define PAPI_L2_ICH (PAPI_PRESET_MASK | 74)
+#define PAPI_L3_ICH (PAPI_PRESET_MASK | 75)
+#define PAPI_L1_ICA (PAPI_PRESET_MASK | 76)
+#define PAPI_L2_ICA (PAPI_PRESET_MASK | 77)
+#define PAPI_L3_ICA (PAPI_PRESET_MASK | 78)
+#define PAPI_L1_ICR (PAPI_PRESET_MASK | 79)
+#define PAPI_L2_ICR (PAPI_PRESET_MASK | 80)
+#define PAPI_L3_ICR (PAPI_PRESET_MASK | 81)
+#define PAPI_L1_ICW (PAPI_PRESET_MASK | 82)
+#define PAPI_L2_ICW (PAPI_PRESET_MASK | 83)
+#define PAPI_L3_ICW (PAPI_PRESET_MASK | 84)
+#define PAPI_L1_TCH (PAPI_PRESET_MASK | 85)
+#define PAPI_L2_TCH (PAPI_PRESET_MASK | 86)
+#define PAPI_L3_TCH (PAPI_PRESET_MASK | 87)
+#define PAPI_L1_TCA (PAPI_PRESET_MASK | 88)
+#define PAPI_L2_TCA (PAPI_PRESET_MASK | 89)
+#define PAPI_L3_TCA (PAPI_PRESET_MASK | 90)
+#define PAPI_L1_TCR (PAPI_PRESET_MASK | 91)
+#define PAPI_L2_TCR (PAPI_PRESET_MASK | 92)
+#define PAPI_L3_TCR (PAPI_PRESET_MASK | 93)
+#define PAPI_L1_TCW (PAPI_PRESET_MASK | 94)
+#define PAPI_L2_TCW (PAPI_PRESET_MASK | 95)
+#define PAPI_L3_TCW (PAPI_PRESET_MASK | 96)
+#define PAPI_FML_INS (PAPI_PRESET_MASK | 97)
+#define PAPI_FAD_INS (PAPI_PRESET_MASK | 98)
+#define PAPI_FDV_INS (PAPI_PRESET_MASK | 99)
+#define PAPI_FSQ_INS (PAPI_PRESET_MASK | 100)
+#define PAPI_FNV_INS (PAPI_PRESET_MASK | 101)
+#define PAPI_FP_OPS (PAPI_PRESET_MASK | 102)
+#define PAPI_SP_OPS (PAPI_PRESET_MASK | 103)
+#define PAPI_DP_OPS (PAPI_PRESET_MASK | 104)
+#define PAPI_VEC_SP (PAPI_PRESET_MASK | 105)
+#define PAPI_VEC_DP (PAPI_PRESET_MASK | 106)
+#define PAPI_REF_CYC (PAPI_PRESET_MASK | 107)
+#endif
+
+#endif
+#endif
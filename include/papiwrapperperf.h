@@ -0,0 +1,626 @@
+#ifndef PAPIWRAPPERPERF
+#define PAPIWRAPPERPERF
+#if !defined(NOPAPIW) && defined(__linux__)
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "./papiwrapperbackend.h"
+
+/* Maximum number of event sets the perf_event_open backend can hold at the same time */
+#ifndef PAPIW_PERF_EVENT_SETS
+#define PAPIW_PERF_EVENT_SETS 4096
+#endif
+
+/**
+ * Backend which counts with the perf_event_open system call of Linux, without libpapi
+ *
+ * Every event set is one event group of the calling thread, s.t. a single read returns all its counters at once,
+ * together with the time the group was enabled and running. The preset events map to the nearest generic
+ * hardware and cache events of the kernel, where the generic cache events only count reads. The software events
+ * of the kernel are available on every Linux machine, even without access to hardware counters:
+ *     perf::TASK-CLOCK, perf::CPU-CLOCK, perf::CONTEXT-SWITCHES, perf::CPU-MIGRATIONS,
+ *     perf::PAGE-FAULTS, perf::MINOR-FAULTS, perf::MAJOR-FAULTS
+ *
+ * Multiplexed event sets open one group per event, which the kernel schedules independently. Values of groups
+ * which were not running the whole time are scaled by time enabled / time running. Hardware events only count
+ * user space, like the default domain of Papi. Sampling with overflows is not supported.
+ *
+ * The first page of every hardware event is mapped, s.t. Read of a running event set uses rdpmc in user space
+ * where the kernel allows it. Read falls back to the system call as soon as one event is not on a counter,
+ * was not running the whole time or is a software event.
+ *
+ * Example of use:
+ *     PapiWrapperPerfBackend perf;
+ *     PAPIW::SET_BACKEND(&perf);
+ *     PAPIW::INIT_SINGLE(PAPI_TOT_INS, "perf::CONTEXT-SWITCHES");
+ *
+ * @note In builds without libpapi (PAPIW_PERF_EVENT), this is the default backend
+ */
+class PapiWrapperPerfBackend : public PapiWrapperBackend
+{
+public:
+    PapiWrapperPerfBackend() : eventSets(PAPIW_PERF_EVENT_SETS) {}
+    ~PapiWrapperPerfBackend()
+    {
+        for (auto eventSet : eventSets)
+        {
+            if (eventSet != nullptr)
+                closeGroups(*eventSet);
+            delete eventSet;
+        }
+    }
+
+    const char *Name() override
+    {
+        return "perf_event";
+    }
+
+    /* The kernel provides perf_event_paranoid iff it supports perf_event_open */
+    int LibraryInit() override
+    {
+        return access("/proc/sys/kernel/perf_event_paranoid", F_OK) == 0 ? PAPI_OK : PAPI_ECMP;
+    }
+
+    int MultiplexInit() override
+    {
+        return PAPI_OK;
+    }
+
+    int ThreadInit() override
+    {
+        return PAPI_OK;
+    }
+
+    int RegisterThread() override
+    {
+        return PAPI_OK;
+    }
+
+    int UnregisterThread() override
+    {
+        return PAPI_OK;
+    }
+
+    unsigned long ThreadId() override
+    {
+        return pthread_self();
+    }
+
+    int CreateEventSet(int *eventSet) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        int handle;
+        if (!freeEventSets.empty())
+        {
+            handle = freeEventSets.back();
+            freeEventSets.pop_back();
+        }
+        else if (nextEventSet < PAPIW_PERF_EVENT_SETS)
+            handle = nextEventSet++;
+        else
+            return PAPI_ENOMEM;
+
+        eventSets[handle] = new EventSet();
+        *eventSet = handle;
+        return PAPI_OK;
+    }
+
+    /* There is only the cpu component */
+    int AssignEventSetComponent(const int eventSet, const int component) override
+    {
+        if (find(eventSet) == nullptr)
+            return PAPI_ENOEVST;
+        return component == 0 ? PAPI_OK : PAPI_EINVAL;
+    }
+
+    int SetMultiplex(const int eventSet) override
+    {
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (!set->events.empty())
+            return PAPI_EINVAL;
+
+        set->multiplexed = true;
+        return PAPI_OK;
+    }
+
+    /* Opens the event right away, s.t. a group which does not fit on the counters is reported as conflict */
+    int AddEvent(const int eventSet, const int eventCode) override
+    {
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (set->running)
+            return PAPI_EISRUN;
+
+        auto event = lookup(eventCode);
+        if (event == nullptr)
+            return PAPI_ENOEVNT;
+        if (std::find(set->events.begin(), set->events.end(), eventCode) != set->events.end())
+            return PAPI_ECNFLCT;
+
+        bool leader = set->multiplexed || set->leaders.empty();
+        int fd = open(*event, leader ? -1 : set->leaders.back());
+        if (fd < 0)
+            return status(-fd, !leader);
+
+        if (leader)
+        {
+            set->leaders.push_back(fd);
+            set->sizes.push_back(0);
+        }
+        set->sizes.back()++;
+        set->fds.push_back(fd);
+        set->pages.push_back(event->type == PERF_TYPE_SOFTWARE ? nullptr : map(fd));
+        set->events.push_back(eventCode);
+        set->buffer.resize(3 + set->events.size());
+        return PAPI_OK;
+    }
+
+    int CleanupEventSet(const int eventSet) override
+    {
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (set->running)
+            return PAPI_EISRUN;
+
+        closeGroups(*set);
+        return PAPI_OK;
+    }
+
+    int DestroyEventSet(int *eventSet) override
+    {
+        auto set = find(*eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (!set->events.empty())
+            return PAPI_EINVAL;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        delete set;
+        eventSets[*eventSet] = nullptr;
+        freeEventSets.push_back(*eventSet);
+        *eventSet = PAPI_NULL;
+        return PAPI_OK;
+    }
+
+    int Start(const int eventSet) override
+    {
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (set->running)
+            return PAPI_EISRUN;
+        if (set->events.empty())
+            return PAPI_EINVAL;
+
+        for (auto leader : set->leaders)
+        {
+            if (ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) != 0 ||
+                ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0)
+                return PAPI_ESYS;
+        }
+        set->running = true;
+        return PAPI_OK;
+    }
+
+    int Stop(const int eventSet, long long *values) override
+    {
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (!set->running)
+            return PAPI_ENOTRUN;
+
+        for (auto leader : set->leaders)
+        {
+            if (ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP) != 0)
+                return PAPI_ESYS;
+        }
+        set->running = false;
+        return readGroups(*set, values);
+    }
+
+    int Read(const int eventSet, long long *values) override
+    {
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (set->running && readUserSpace(*set, values))
+            return PAPI_OK;
+        return readGroups(*set, values);
+    }
+
+    int Accum(const int eventSet, long long *values) override
+    {
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (!set->running)
+            return PAPI_ENOTRUN;
+
+        set->values.resize(set->events.size());
+        int retval = readGroups(*set, set->values.data());
+        if (retval != PAPI_OK)
+            return retval;
+
+        for (auto leader : set->leaders)
+        {
+            if (ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) != 0)
+                return PAPI_ESYS;
+        }
+        int count = set->values.size();
+        for (int i = 0; i < count; i++)
+            values[i] += set->values[i];
+        return PAPI_OK;
+    }
+
+    long long GetRealNsec() override
+    {
+        return nsec(CLOCK_MONOTONIC);
+    }
+
+    long long GetVirtNsec() override
+    {
+        return nsec(CLOCK_THREAD_CPUTIME_ID);
+    }
+
+    /* Opens the event once on the calling thread, s.t. events the machine does not count are rejected */
+    int QueryEvent(const int eventCode) override
+    {
+        auto event = lookup(eventCode);
+        if (event == nullptr)
+            return PAPI_ENOEVNT;
+
+        int fd = open(*event, -1);
+        if (fd < 0)
+            return status(-fd, false);
+        close(fd);
+        return PAPI_OK;
+    }
+
+    int EventNameToCode(const char *name, int *eventCode) override
+    {
+        for (auto &event : events())
+        {
+            if (strcmp(event.name, name) == 0)
+            {
+                *eventCode = event.code;
+                return PAPI_OK;
+            }
+        }
+        return PAPI_ENOEVNT;
+    }
+
+    int EventCodeToName(const int eventCode, char *name) override
+    {
+        auto event = lookup(eventCode);
+        if (event == nullptr)
+            return PAPI_ENOEVNT;
+
+        snprintf(name, PAPI_MAX_STR_LEN, "%s", event->name);
+        return PAPI_OK;
+    }
+
+    int GetEventInfo(const int eventCode, std::string &symbol, std::string &description, std::string &units) override
+    {
+        auto event = lookup(eventCode);
+        if (event == nullptr)
+            return PAPI_ENOEVNT;
+
+        symbol = event->name;
+        description = event->description;
+        units = event->units;
+        return PAPI_OK;
+    }
+
+    /* True if the kernel lets the calling thread read its hardware counters with rdpmc */
+    bool FastCounterRead() override
+    {
+        static const bool supported = probeUserSpaceRead();
+        return supported;
+    }
+
+    int Overflow(const int, const int, const int, PAPI_overflow_handler_t) override
+    {
+        return PAPI_ENOSUPP;
+    }
+
+    int GetOverflowEventIndex(const int, const long long, int *, int *) override
+    {
+        return PAPI_ENOSUPP;
+    }
+
+private:
+    /* An event of the kernel, as type and config of perf_event_attr */
+    struct PerfEvent
+    {
+        int code;
+        const char *name;
+        uint32_t type;
+        uint64_t config;
+        const char *description;
+        const char *units;
+    };
+
+    /* Only the thread which created an event set uses it, so it needs no synchronization */
+    struct EventSet
+    {
+        std::vector<int> events;
+        std::vector<int> fds;           // One per event
+        std::vector<perf_event_mmap_page *> pages; // Mapped first page of every event, nullptr if not mapped
+        std::vector<int> leaders;       // One per group
+        std::vector<size_t> sizes;      // Number of events of every group
+        std::vector<uint64_t> buffer;   // Read format of a group: nr, time enabled, time running, values
+        std::vector<long long> values;  // Scratch space of Accum
+        bool multiplexed = false;
+        bool running = false;
+    };
+
+    std::vector<EventSet *> eventSets;
+    std::vector<int> freeEventSets;
+    int nextEventSet = 0;
+    std::mutex mutex; // Guards the allocation of event sets
+
+    /* Config of a generic cache event */
+    static constexpr uint64_t cache(const uint64_t cache, const uint64_t operation, const uint64_t result)
+    {
+        return cache | operation << 8 | result << 16;
+    }
+
+    /* The presets with a generic counterpart and the software events, as native events */
+    static const std::vector<PerfEvent> &events()
+    {
+        static const std::vector<PerfEvent> events = {
+            {PAPI_TOT_INS, "PAPI_TOT_INS", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "Instructions completed", ""},
+            {PAPI_TOT_CYC, "PAPI_TOT_CYC", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "Total cycles", ""},
+            {PAPI_REF_CYC, "PAPI_REF_CYC", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES, "Reference clock cycles", ""},
+            {PAPI_BR_INS, "PAPI_BR_INS", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, "Branch instructions", ""},
+            {PAPI_BR_MSP, "PAPI_BR_MSP", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "Branch instructions mispredicted", ""},
+            {PAPI_STL_ICY, "PAPI_STL_ICY", PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND, "Cycles with no instruction issue", ""},
+            {PAPI_RES_STL, "PAPI_RES_STL", PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND, "Cycles stalled on any resource", ""},
+            {PAPI_L3_TCA, "PAPI_L3_TCA", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES, "Last level cache accesses", ""},
+            {PAPI_L3_TCM, "PAPI_L3_TCM", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "Last level cache misses", ""},
+            {PAPI_L1_DCA, "PAPI_L1_DCA", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_ACCESS), "Level 1 data cache reads", ""},
+            {PAPI_L1_DCM, "PAPI_L1_DCM", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), "Level 1 data cache read misses", ""},
+            {PAPI_L1_STM, "PAPI_L1_STM", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_WRITE, PERF_COUNT_HW_CACHE_RESULT_MISS), "Level 1 data cache write misses", ""},
+            {PAPI_L1_ICM, "PAPI_L1_ICM", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1I, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), "Level 1 instruction cache misses", ""},
+            {PAPI_L3_LDM, "PAPI_L3_LDM", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), "Last level cache load misses", ""},
+            {PAPI_L3_STM, "PAPI_L3_STM", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_WRITE, PERF_COUNT_HW_CACHE_RESULT_MISS), "Last level cache store misses", ""},
+            {PAPI_TLB_DM, "PAPI_TLB_DM", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), "Data translation lookaside buffer misses", ""},
+            {PAPI_TLB_IM, "PAPI_TLB_IM", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_ITLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), "Instruction translation lookaside buffer misses", ""},
+            {PAPI_NATIVE_MASK | 0, "perf::TASK-CLOCK", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "Time the thread was running", "ns"},
+            {PAPI_NATIVE_MASK | 1, "perf::CPU-CLOCK", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK, "Time of the cpu clock while the thread was running", "ns"},
+            {PAPI_NATIVE_MASK | 2, "perf::CONTEXT-SWITCHES", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "Context switches", ""},
+            {PAPI_NATIVE_MASK | 3, "perf::CPU-MIGRATIONS", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS, "Migrations to another cpu", ""},
+            {PAPI_NATIVE_MASK | 4, "perf::PAGE-FAULTS", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "Page faults", ""},
+            {PAPI_NATIVE_MASK | 5, "perf::MINOR-FAULTS", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN, "Page faults without disk access", ""},
+            {PAPI_NATIVE_MASK | 6, "perf::MAJOR-FAULTS", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ, "Page faults with disk access", ""},
+        };
+        return events;
+    }
+
+    static const PerfEvent *lookup(const int eventCode)
+    {
+        for (auto &event : events())
+        {
+            if (event.code == eventCode)
+                return &event;
+        }
+        return nullptr;
+    }
+
+    EventSet *find(const int eventSet)
+    {
+        if (eventSet < 0 || eventSet >= PAPIW_PERF_EVENT_SETS)
+            return nullptr;
+        return eventSets[eventSet];
+    }
+
+    /* Open an event of the calling thread on any cpu, as leader of a new group (-1) or as member of group */
+    static int open(const PerfEvent &event, const int group)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = group == -1; // Members follow their leader
+        attr.exclude_hv = 1;
+        /* Software events like context switches happen in the kernel */
+        attr.exclude_kernel = event.type != PERF_TYPE_SOFTWARE;
+
+        int fd = syscall(SYS_perf_event_open, &attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC);
+        if (fd < 0 && !attr.exclude_kernel && (errno == EACCES || errno == EPERM))
+        {
+            /* Counting in the kernel needs perf_event_paranoid < 2 */
+            attr.exclude_kernel = 1;
+            fd = syscall(SYS_perf_event_open, &attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC);
+        }
+        return fd >= 0 ? fd : -errno;
+    }
+
+    /* Map an errno of perf_event_open to a Papi status */
+    static int status(const int error, const bool member)
+    {
+        switch (error)
+        {
+        case ENOENT:
+        case ENODEV:
+        case EOPNOTSUPP:
+            return PAPI_ENOEVNT;
+        case EACCES:
+        case EPERM:
+            return PAPI_EPERM;
+        case EINVAL:
+        case ENOSPC:
+            return member ? PAPI_ECNFLCT : PAPI_EINVAL; // The group does not fit on the counters
+        case EMFILE:
+        case ENFILE:
+            return PAPI_ENOMEM;
+        default:
+            return PAPI_ESYS;
+        }
+    }
+
+    /* Read every group with a single read and scale groups which did not run the whole time they were enabled */
+    static int readGroups(EventSet &set, long long *values)
+    {
+        size_t offset = 0;
+        int groups = set.leaders.size();
+        for (int group = 0; group < groups; group++)
+        {
+            size_t size = set.sizes[group];
+            ssize_t bytes = (3 + size) * sizeof(uint64_t);
+            if (read(set.leaders[group], set.buffer.data(), bytes) != bytes)
+                return PAPI_ESYS;
+
+            uint64_t enabled = set.buffer[1];
+            uint64_t running = set.buffer[2];
+            for (size_t i = 0; i < size; i++)
+            {
+                uint64_t value = set.buffer[3 + i];
+                if (running < enabled)
+                    value = running == 0 ? 0 : static_cast<uint64_t>(static_cast<double>(value) * enabled / running);
+                values[offset + i] = value;
+            }
+            offset += size;
+        }
+        return PAPI_OK;
+    }
+
+    static void closeGroups(EventSet &set)
+    {
+        for (auto page : set.pages)
+            if (page != nullptr)
+                munmap(page, sysconf(_SC_PAGESIZE));
+        for (auto fd : set.fds)
+            close(fd);
+        set.events.clear();
+        set.fds.clear();
+        set.pages.clear();
+        set.leaders.clear();
+        set.sizes.clear();
+    }
+
+    /* Map the first page of an event, which holds what rdpmc needs. nullptr if it can not be mapped */
+    static perf_event_mmap_page *map(const int fd)
+    {
+        void *page = mmap(nullptr, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fd, 0);
+        return page != MAP_FAILED ? static_cast<perf_event_mmap_page *>(page) : nullptr;
+    }
+
+    /**
+     * Read the counters of a running event set with rdpmc, as documented in linux/perf_event.h
+     *
+     * @return False if any event can not be read in user space right now or was not running the whole time
+     */
+    static bool readUserSpace(EventSet &set, long long *values)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        int count = set.events.size();
+        for (int i = 0; i < count; i++)
+        {
+            volatile perf_event_mmap_page *page = set.pages[i];
+            if (page == nullptr)
+                return false;
+
+            uint32_t sequence;
+            int64_t value;
+            uint64_t enabled, running;
+            do
+            {
+                sequence = page->lock;
+                asm volatile("" ::: "memory");
+                uint32_t index = page->index;
+                if (!page->cap_user_rdpmc || index == 0)
+                    return false;
+
+                enabled = page->time_enabled;
+                running = page->time_running;
+                int shift = 64 - page->pmc_width;
+                value = page->offset + (static_cast<int64_t>(rdpmc(index - 1) << shift) >> shift);
+                asm volatile("" ::: "memory");
+            } while (page->lock != sequence);
+
+            if (running != enabled)
+                return false;
+            values[i] = value;
+        }
+        return true;
+#else
+        (void)set;
+        (void)values;
+        return false;
+#endif
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    static uint64_t rdpmc(const uint32_t counter)
+    {
+        uint32_t low, high;
+        asm volatile("rdpmc" : "=a"(low), "=d"(high) : "c"(counter));
+        return static_cast<uint64_t>(high) << 32 | low;
+    }
+#endif
+
+    /* Count instructions of the calling thread for a moment and check whether the kernel allows rdpmc for them */
+    static bool probeUserSpaceRead()
+    {
+        int fd = open(*lookup(PAPI_TOT_INS), -1);
+        if (fd < 0)
+            return false;
+
+        bool supported = false;
+        auto page = map(fd);
+        if (page != nullptr)
+        {
+            if (ioctl(fd, PERF_EVENT_IOC_ENABLE, 0) == 0)
+            {
+                EventSet set;
+                set.events.push_back(PAPI_TOT_INS);
+                set.pages.push_back(page);
+                long long value;
+                supported = readUserSpace(set, &value);
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+            munmap(page, sysconf(_SC_PAGESIZE));
+        }
+        close(fd);
+        return supported;
+    }
+
+    static long long nsec(const clockid_t clock)
+    {
+        timespec time;
+        clock_gettime(clock, &time);
+        return time.tv_sec * 1000000000LL + time.tv_nsec;
+    }
+};
+
+#ifdef PAPIW_PERF_EVENT
+inline PapiWrapperBackend &PapiWrapperBackend::Default()
+{
+    static PapiWrapperPerfBackend perf;
+    return perf;
+}
+#endif
+
+#endif
+#endif
@@ -0,0 +1,78 @@
+#ifndef PAPIWRAPPERPLANNER
+#define PAPIWRAPPERPLANNER
+#ifndef NOPAPIW
+
+#include <algorithm>
+#include <vector>
+#include "./papiwrapperpapi.h"
+#include "./papiwrapperbackend.h"
+
+/**
+ * Partitions events into groups which fit into one event set each
+ *
+ * Every event is tried on the groups in order with a trial event set and opens a new group if it conflicts
+ * with all of them. The groups only depend on the order of the events, s.t. repeated runs measure the same passes.
+ */
+class PapiWrapperPlanner
+{
+public:
+    /**
+     * @param events Events in the order they were requested. Duplicates are ignored
+     * @param skipped Receives the events which are not available or can not even be counted alone
+     * @return The groups, each in the order of the requested events
+     */
+    static std::vector<std::vector<int>> Plan(const std::vector<int> &events, std::vector<int> &skipped)
+    {
+        std::vector<std::vector<int>> groups;
+        std::vector<int> eventSets;
+        std::vector<int> planned;
+        for (auto eventCode : events)
+        {
+            if (std::find(planned.begin(), planned.end(), eventCode) != planned.end())
+                continue;
+            if (PapiWrapperBackend::Get().QueryEvent(eventCode) != PAPI_OK)
+            {
+                skipped.push_back(eventCode);
+                continue;
+            }
+
+            size_t group = 0;
+            while (group < groups.size() && PapiWrapperBackend::Get().AddEvent(eventSets[group], eventCode) != PAPI_OK)
+                group++;
+
+            if (group == groups.size())
+            {
+                int eventSet = PAPI_NULL;
+                if (PapiWrapperBackend::Get().CreateEventSet(&eventSet) != PAPI_OK)
+                {
+                    skipped.push_back(eventCode);
+                    continue;
+                }
+                if (PapiWrapperBackend::Get().AddEvent(eventSet, eventCode) != PAPI_OK)
+                {
+                    release(eventSet);
+                    skipped.push_back(eventCode);
+                    continue;
+                }
+                eventSets.push_back(eventSet);
+                groups.emplace_back();
+            }
+            groups[group].push_back(eventCode);
+            planned.push_back(eventCode);
+        }
+
+        for (auto &eventSet : eventSets)
+            release(eventSet);
+        return groups;
+    }
+
+private:
+    static void release(int &eventSet)
+    {
+        PapiWrapperBackend::Get().CleanupEventSet(eventSet);
+        PapiWrapperBackend::Get().DestroyEventSet(&eventSet);
+    }
+};
+
+#endif
+#endif
@@ -0,0 +1,281 @@
+#ifndef PAPIWRAPPERREGIONS
+#define PAPIWRAPPERREGIONS
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include "./papiwrappercalltree.h"
+
+/* Maximum number of distinct named regions. Has to be a power of two */
+#ifndef PAPIW_MAX_REGIONS
+#define PAPIW_MAX_REGIONS 256
+#endif
+
+/* Maximum nesting depth of named regions per thread */
+#ifndef PAPIW_MAX_REGION_DEPTH
+#define PAPIW_MAX_REGION_DEPTH 32
+#endif
+
+namespace PAPIW
+{
+    /* FNV-1a hash of a region name, evaluated at compile time for string literals */
+    constexpr uint64_t HashRegionName(const char *name)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (; *name != '\0'; name++)
+            hash = (hash ^ static_cast<unsigned char>(*name)) * 1099511628211ull;
+        return hash;
+    }
+
+    /**
+     * Name of a measurement region together with its hash
+     *
+     * @note The name is not copied, so it must outlive the measurement (e.g. a string literal)
+     */
+    struct RegionName
+    {
+        const char *name;
+        uint64_t hash;
+
+        constexpr RegionName(const char *name) : name(name), hash(HashRegionName(name)) {}
+    };
+} // namespace PAPIW
+
+/**
+ * Accumulated values of named regions of one thread
+ *
+ * The regions are found through an open addressing table keyed by the hash of their name.
+ * Storage for all regions is reserved up front, s.t. entering and leaving a region never allocates.
+ * Additionally, the currently open regions are kept on a stack together with the counter values at entry.
+ * Nested regions are recorded in a call tree as well, s.t. inclusive and exclusive values are known per call path.
+ */
+class PapiWrapperRegions
+{
+private:
+    static int const tableSize = PAPIW_MAX_REGIONS;
+    static_assert((tableSize & (tableSize - 1)) == 0, "PAPIW_MAX_REGIONS must be a power of two");
+
+    /* One open region */
+    struct Frame
+    {
+        int region;
+        bool owner; // True if entering this region started the counters
+        PapiWrapperCallTree::Node *node;
+    };
+
+    const int eventCount;
+    int table[tableSize];          // Index into the region lists or -1 for empty buckets
+    std::vector<uint64_t> hashes;  // Hash of every region in order of their first use
+    std::vector<const char *> names;
+    std::vector<long long> values; // eventCount values per region
+    std::vector<long long> intervals;
+    Frame stack[PAPIW_MAX_REGION_DEPTH];
+    int depth = 0;
+    std::vector<long long> snapshots; // eventCount values per open region
+    std::vector<long long> scratch;
+    PapiWrapperCallTree tree;
+
+public:
+    PapiWrapperRegions(const int eventCount)
+        : eventCount(eventCount), snapshots(PAPIW_MAX_REGION_DEPTH * eventCount), scratch(eventCount), tree(eventCount)
+    {
+        std::fill(table, table + tableSize, -1);
+        hashes.reserve(tableSize);
+        names.reserve(tableSize);
+        values.reserve(tableSize * eventCount);
+        intervals.reserve(tableSize);
+    }
+
+    /* Get the index of a region, inserting it on first use. Returns -1 if the table is full */
+    int Find(const PAPIW::RegionName &name)
+    {
+        for (int probe = 0; probe < tableSize; probe++)
+        {
+            int &bucket = table[(name.hash + probe) & (tableSize - 1)];
+            if (bucket == -1)
+            {
+                bucket = hashes.size();
+                hashes.push_back(name.hash);
+                names.push_back(name.name);
+                values.insert(values.end(), eventCount, 0);
+                intervals.push_back(0);
+                return bucket;
+            }
+            if (hashes[bucket] == name.hash)
+                return bucket;
+        }
+        return -1;
+    }
+
+    /* Get the index of a region or -1 if it has never been entered */
+    int Lookup(const PAPIW::RegionName &name) const
+    {
+        for (int probe = 0; probe < tableSize; probe++)
+        {
+            int bucket = table[(name.hash + probe) & (tableSize - 1)];
+            if (bucket == -1 || hashes[bucket] == name.hash)
+                return bucket;
+        }
+        return -1;
+    }
+
+    /**
+     * Open a region
+     *
+     * @param owner True if the counters were started for this region and have to be stopped on Leave
+     * @return Storage for the counter values at entry or nullptr if the region can't be opened
+     */
+    long long *Enter(const PAPIW::RegionName &name, const bool owner)
+    {
+        int region = Find(name);
+        if (region == -1 || depth == PAPIW_MAX_REGION_DEPTH)
+            return nullptr;
+
+        auto parent = depth == 0 ? tree.Root() : stack[depth - 1].node;
+        stack[depth] = {region, owner, tree.Child(parent, name.hash, name.name)};
+        return &snapshots[eventCount * depth++];
+    }
+
+    /**
+     * Close the innermost region and accumulate the difference to the values at entry
+     *
+     * @param current the counter values at exit
+     * @return False if the innermost region has a different name
+     */
+    bool Leave(const PAPIW::RegionName &name, const long long *current)
+    {
+        if (depth == 0 || hashes[stack[depth - 1].region] != name.hash)
+            return false;
+
+        depth--;
+        int region = stack[depth].region;
+        auto node = stack[depth].node;
+        const long long *snapshot = &snapshots[eventCount * depth];
+        long long *regionValues = &values[eventCount * region];
+        for (int i = 0; i < eventCount; i++)
+        {
+            long long delta = current[i] - snapshot[i];
+            regionValues[i] += delta;
+            node->values[i] += delta;
+        }
+        intervals[region]++;
+        node->intervals++;
+        return true;
+    }
+
+    /* Counter values at entry of the innermost region */
+    const long long *Snapshot() const
+    {
+        return &snapshots[eventCount * (depth - 1)];
+    }
+
+    /* True if the counters were started when entering the innermost region */
+    bool IsOwner()
+    {
+        return depth != 0 && stack[depth - 1].owner;
+    }
+
+    /* Storage for eventCount values, e.g. to read the counters at exit */
+    long long *Scratch()
+    {
+        return scratch.data();
+    }
+
+    /* Number of currently open regions */
+    int Depth()
+    {
+        return depth;
+    }
+
+    /**
+     * Add the values of all regions of another thread
+     *
+     * @return False if the table is full and some regions were skipped. The call tree holds them nonetheless
+     */
+    bool Add(const PapiWrapperRegions &other)
+    {
+        bool complete = true;
+        int count = other.hashes.size();
+        for (int i = 0; i < count; i++)
+        {
+            int region = Find({other.names[i]});
+            if (region == -1)
+            {
+                complete = false;
+                continue;
+            }
+            for (int j = 0; j < eventCount; j++)
+                values[eventCount * region + j] += other.values[eventCount * i + j];
+            intervals[region] += other.intervals[i];
+        }
+        tree.Add(other.tree);
+        return complete;
+    }
+
+    /**
+     * Add the values of all regions of a pass which counted a subset of the events
+     *
+     * @param columns Position of every event of the pass in the own events
+     * @return False if the table is full and some regions were skipped
+     */
+    bool AddPass(const PapiWrapperRegions &other, const std::vector<int> &columns)
+    {
+        bool complete = true;
+        int count = other.hashes.size();
+        for (int i = 0; i < count; i++)
+        {
+            int region = Find({other.names[i]});
+            if (region == -1)
+            {
+                complete = false;
+                continue;
+            }
+            for (size_t j = 0; j < columns.size(); j++)
+                values[eventCount * region + columns[j]] += other.values[other.eventCount * i + j];
+
+            /* Every pass runs the same code, so its intervals are only counted once */
+            intervals[region] = std::max(intervals[region], other.intervals[i]);
+        }
+        return complete;
+    }
+
+    /* Set all values to zero but keep the known regions */
+    void Reset()
+    {
+        std::fill(values.begin(), values.end(), 0);
+        std::fill(intervals.begin(), intervals.end(), 0);
+        tree.Reset();
+    }
+
+    /* Number of known regions */
+    int Size() const
+    {
+        return hashes.size();
+    }
+
+    /* Name of a region */
+    const char *Name(const int region) const
+    {
+        return names[region];
+    }
+
+    /* Number of closed intervals of a region */
+    long long Intervals(const int region) const
+    {
+        return intervals[region];
+    }
+
+    /* Accumulated values of a region */
+    const long long *Values(const int region) const
+    {
+        return &values[eventCount * region];
+    }
+
+    /* Call tree of the nested regions */
+    const PapiWrapperCallTree &CallTree() const
+    {
+        return tree;
+    }
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef PAPIWRAPPERSAMPLES
+#define PAPIWRAPPERSAMPLES
+#ifndef NOPAPIW
+
+#include <stdint.h>
+#include <stdio.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include "./papiwrapperpapi.h"
+#include "./papiwrapperbackend.h"
+
+/* Number of samples a thread can record between two Stops. Has to be a power of two */
+#ifndef PAPIW_SAMPLE_BUFFER_SIZE
+#define PAPIW_SAMPLE_BUFFER_SIZE 4096
+#endif
+
+/* Number of functions and addresses listed per event in the sample report */
+#ifndef PAPIW_SAMPLE_TOP
+#define PAPIW_SAMPLE_TOP 10
+#endif
+
+/**
+ * Instruction pointer samples of one thread
+ *
+ * The overflow signal handler pushes into a fixed size ring buffer without locks or allocation.
+ * Whenever the counters are stopped, the ring buffer is drained into per-event histograms.
+ */
+class PapiWrapperSamples
+{
+private:
+    static uint32_t const bufferSize = PAPIW_SAMPLE_BUFFER_SIZE;
+    static_assert((bufferSize & (bufferSize - 1)) == 0, "PAPIW_SAMPLE_BUFFER_SIZE must be a power of two");
+
+    struct Sample
+    {
+        void *address;
+        long long overflowVector;
+    };
+
+    Sample ring[bufferSize];
+    std::atomic<uint32_t> head{0}; // Written by the signal handler only
+    std::atomic<uint32_t> tail{0}; // Written by Drain only
+    std::atomic<long long> dropped{0};
+    std::map<int, std::unordered_map<void *, long long>> histograms; // Sample count per address for every event code
+
+public:
+    /* Record a sample. Async signal safe, the sample is dropped if the buffer is full */
+    void Push(void *address, const long long overflowVector)
+    {
+        uint32_t position = head.load(std::memory_order_relaxed);
+        if (position - tail.load(std::memory_order_acquire) == bufferSize)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        ring[position & (bufferSize - 1)] = {address, overflowVector};
+        head.store(position + 1, std::memory_order_release);
+    }
+
+    /* Move the recorded samples of an event set into the histograms */
+    void Drain(const int eventSet, const std::vector<int> &events)
+    {
+        uint32_t position = tail.load(std::memory_order_relaxed);
+        uint32_t end = head.load(std::memory_order_acquire);
+        for (; position != end; position++)
+        {
+            auto &sample = ring[position & (bufferSize - 1)];
+            int indices[8];
+            int number = 8;
+            if (PapiWrapperBackend::Get().GetOverflowEventIndex(eventSet, sample.overflowVector, indices, &number) != PAPI_OK)
+                continue;
+            for (int i = 0; i < number; i++)
+                if (indices[i] >= 0 && indices[i] < static_cast<int>(events.size()))
+                    histograms[events[indices[i]]][sample.address]++;
+        }
+        tail.store(position, std::memory_order_release);
+    }
+
+    /* Add the histograms of another thread */
+    void Add(const PapiWrapperSamples &other)
+    {
+        for (auto &event : other.histograms)
+            for (auto &address : event.second)
+                histograms[event.first][address.first] += address.second;
+        dropped += other.dropped.load();
+    }
+
+    /* Forget all samples */
+    void Reset()
+    {
+        histograms.clear();
+        dropped = 0;
+    }
+
+    /* Number of samples which did not fit into the buffer */
+    long long Dropped() const
+    {
+        return dropped.load();
+    }
+
+    /* Sample count per address for every event code */
+    const std::map<int, std::unordered_map<void *, long long>> &Histograms() const
+    {
+        return histograms;
+    }
+
+    /* Name of the function containing an address, or the address itself if it can not be resolved */
+    static std::string Symbolize(void *address, const bool withOffset)
+    {
+        char text[64];
+        Dl_info info;
+        if (dladdr(address, &info) == 0 || info.dli_sname == nullptr)
+        {
+            snprintf(text, sizeof(text), "%p", address);
+            return text;
+        }
+
+        int status;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::string name = status == 0 ? demangled : info.dli_sname;
+        free(demangled);
+
+        if (withOffset)
+        {
+            snprintf(text, sizeof(text), "+0x%lx", static_cast<unsigned long>(static_cast<char *>(address) - static_cast<char *>(info.dli_saddr)));
+            name += text;
+        }
+        return name;
+    }
+};
+
+#endif
+#endif
@@ -0,0 +1,440 @@
+#ifndef PAPIWRAPPERSIMULATED
+#define PAPIWRAPPERSIMULATED
+#ifndef NOPAPIW
+
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "./papiwrapperbackend.h"
+#include "./papiwrapperdescriptions.h"
+
+/* Maximum number of event sets the simulated backend can hold at the same time. Destroyed event sets are reused */
+#ifndef PAPIW_SIMULATED_EVENT_SETS
+#define PAPIW_SIMULATED_EVENT_SETS 4096
+#endif
+
+/**
+ * Backend with deterministic counters, which needs neither hardware counters nor libpapi at run time
+ *
+ * Every event follows a script of deltas: Whenever a running event set is read or stopped, each event advances
+ * by the next delta of its script, starting over at the end. The clocks advance by a fixed step whenever they
+ * are queried, the virtual clock per thread. Calls can be scripted to fail, s.t. error paths can be tested.
+ *
+ * Example of use:
+ *     PapiWrapperSimulatedBackend simulated;
+ *     simulated.Script(PAPI_TOT_INS, {1000, 2000});
+ *     simulated.FailAt(PapiWrapperSimulatedBackend::Call::Start, 3, PAPI_ECNFLCT);
+ *     PAPIW::SET_BACKEND(&simulated);
+ *     PAPIW::INIT_PARALLEL(PAPI_TOT_INS, PAPI_TOT_CYC);
+ *
+ * @warning Scripts and failures have to be set up before the backend is used
+ */
+class PapiWrapperSimulatedBackend : public PapiWrapperBackend
+{
+public:
+    /* Calls which can be scripted to fail */
+    enum class Call
+    {
+        LibraryInit,
+        RegisterThread,
+        CreateEventSet,
+        AddEvent,
+        Start,
+        Stop,
+        Read,
+        Accum,
+        Count
+    };
+
+    PapiWrapperSimulatedBackend() : eventSets(PAPIW_SIMULATED_EVENT_SETS), generations(PAPIW_SIMULATED_EVENT_SETS, 0) {}
+    ~PapiWrapperSimulatedBackend()
+    {
+        for (auto eventSet : eventSets)
+            delete eventSet;
+    }
+
+    /* Set the deltas an event advances by on every read, e.g. {100} for a constant rate */
+    void Script(const int eventCode, const std::vector<long long> &deltas)
+    {
+        scripts[eventCode] = deltas.empty() ? std::vector<long long>{0} : deltas;
+    }
+
+    /* Set the delta of all events without a script */
+    void SetDefaultDelta(const long long delta)
+    {
+        defaultScript = {delta};
+    }
+
+    /* Let QueryEvent and AddEvent fail for an event, like for an event the system does not support */
+    void Unavailable(const int eventCode)
+    {
+        unavailable.insert(eventCode);
+    }
+
+    /* Let the n-th call of an operation, counted from 1 over all threads, fail with retval */
+    void FailAt(const Call call, const long long n, const int retval)
+    {
+        failures[static_cast<int>(call)][n] = retval;
+    }
+
+    /* Set the nanoseconds the clocks advance by whenever they are queried */
+    void SetClockStep(const long long nanoseconds)
+    {
+        clockStep = nanoseconds;
+    }
+
+    /* Get the number of calls of an operation so far */
+    long long GetCalls(const Call call)
+    {
+        return calls[static_cast<int>(call)];
+    }
+
+    /* Get the number of currently registered threads */
+    int GetRegisteredThreads()
+    {
+        return registeredThreads;
+    }
+
+    const char *Name() override
+    {
+        return "simulated";
+    }
+
+    int LibraryInit() override
+    {
+        return fail(Call::LibraryInit);
+    }
+
+    int MultiplexInit() override
+    {
+        return PAPI_OK;
+    }
+
+    int ThreadInit() override
+    {
+        return PAPI_OK;
+    }
+
+    int RegisterThread() override
+    {
+        int retval = fail(Call::RegisterThread);
+        if (retval == PAPI_OK)
+            registeredThreads++;
+        return retval;
+    }
+
+    int UnregisterThread() override
+    {
+        registeredThreads--;
+        return PAPI_OK;
+    }
+
+    unsigned long ThreadId() override
+    {
+        return pthread_self();
+    }
+
+    int CreateEventSet(int *eventSet) override
+    {
+        int retval = fail(Call::CreateEventSet);
+        if (retval != PAPI_OK)
+            return retval;
+
+        /* Destroyed event sets are reused with a new generation in the handle, s.t. stale handles are detected */
+        int index;
+        {
+            std::lock_guard<std::mutex> lock(freeMutex);
+            if (!freeSets.empty())
+            {
+                index = freeSets.back();
+                freeSets.pop_back();
+            }
+            else if (usedSets < PAPIW_SIMULATED_EVENT_SETS)
+                index = usedSets++;
+            else
+                return PAPI_ENOMEM;
+        }
+        eventSets[index] = new EventSet();
+        *eventSet = generations[index] * PAPIW_SIMULATED_EVENT_SETS + index;
+        return PAPI_OK;
+    }
+
+    int AssignEventSetComponent(const int eventSet, const int) override
+    {
+        return find(eventSet) != nullptr ? PAPI_OK : PAPI_ENOEVST;
+    }
+
+    int SetMultiplex(const int eventSet) override
+    {
+        return find(eventSet) != nullptr ? PAPI_OK : PAPI_ENOEVST;
+    }
+
+    int AddEvent(const int eventSet, const int eventCode) override
+    {
+        int retval = fail(Call::AddEvent);
+        if (retval != PAPI_OK)
+            return retval;
+
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (set->running)
+            return PAPI_EISRUN;
+        if (unavailable.count(eventCode) != 0)
+            return PAPI_ENOEVNT;
+
+        set->events.push_back(eventCode);
+        set->positions.push_back(0);
+        set->values.push_back(0);
+        return PAPI_OK;
+    }
+
+    int CleanupEventSet(const int eventSet) override
+    {
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (set->running)
+            return PAPI_EISRUN;
+
+        set->events.clear();
+        set->positions.clear();
+        set->values.clear();
+        return PAPI_OK;
+    }
+
+    int DestroyEventSet(int *eventSet) override
+    {
+        auto set = find(*eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (!set->events.empty())
+            return PAPI_EINVAL;
+
+        int index = *eventSet % PAPIW_SIMULATED_EVENT_SETS;
+        delete set;
+        eventSets[index] = nullptr;
+        generations[index] = (generations[index] + 1) % maxGenerations;
+        {
+            std::lock_guard<std::mutex> lock(freeMutex);
+            freeSets.push_back(index);
+        }
+        *eventSet = PAPI_NULL;
+        return PAPI_OK;
+    }
+
+    int Start(const int eventSet) override
+    {
+        int retval = fail(Call::Start);
+        if (retval != PAPI_OK)
+            return retval;
+
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (set->running)
+            return PAPI_EISRUN;
+
+        std::fill(set->values.begin(), set->values.end(), 0);
+        set->running = true;
+        return PAPI_OK;
+    }
+
+    int Stop(const int eventSet, long long *values) override
+    {
+        int retval = fail(Call::Stop);
+        if (retval != PAPI_OK)
+            return retval;
+
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (!set->running)
+            return PAPI_ENOTRUN;
+
+        advance(*set);
+        std::copy(set->values.begin(), set->values.end(), values);
+        set->running = false;
+        return PAPI_OK;
+    }
+
+    int Read(const int eventSet, long long *values) override
+    {
+        int retval = fail(Call::Read);
+        if (retval != PAPI_OK)
+            return retval;
+
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+
+        if (set->running)
+            advance(*set);
+        std::copy(set->values.begin(), set->values.end(), values);
+        return PAPI_OK;
+    }
+
+    int Accum(const int eventSet, long long *values) override
+    {
+        int retval = fail(Call::Accum);
+        if (retval != PAPI_OK)
+            return retval;
+
+        auto set = find(eventSet);
+        if (set == nullptr)
+            return PAPI_ENOEVST;
+        if (!set->running)
+            return PAPI_ENOTRUN;
+
+        advance(*set);
+        int count = set->values.size();
+        for (int i = 0; i < count; i++)
+        {
+            values[i] += set->values[i];
+            set->values[i] = 0;
+        }
+        return PAPI_OK;
+    }
+
+    long long GetRealNsec() override
+    {
+        return realTime += clockStep;
+    }
+
+    long long GetVirtNsec() override
+    {
+        return virtTime += clockStep;
+    }
+
+    int QueryEvent(const int eventCode) override
+    {
+        return unavailable.count(eventCode) == 0 ? PAPI_OK : PAPI_ENOEVNT;
+    }
+
+    /* Only the names of the preset events are known */
+    int EventNameToCode(const char *name, int *eventCode) override
+    {
+        for (auto &preset : PAPIW::PresetDescriptions)
+        {
+            size_t length = strlen(name);
+            if (strncmp(preset.description, name, length) == 0 && preset.description[length] == ' ')
+            {
+                *eventCode = preset.code;
+                return PAPI_OK;
+            }
+        }
+        return PAPI_ENOEVNT;
+    }
+
+    int EventCodeToName(const int eventCode, char *name) override
+    {
+        const char *description = PAPIW::GetPresetDescription(eventCode);
+        const char *end = strchr(description, ' ');
+        if (strcmp(description, "UNKNOWN CODE") == 0 || end == nullptr)
+            return PAPI_ENOEVNT;
+
+        int length = std::min<int>(end - description, PAPI_MAX_STR_LEN - 1);
+        memcpy(name, description, length);
+        name[length] = '\0';
+        return PAPI_OK;
+    }
+
+    int GetEventInfo(const int eventCode, std::string &symbol, std::string &description, std::string &units) override
+    {
+        char name[PAPI_MAX_STR_LEN];
+        int retval = EventCodeToName(eventCode, name);
+        if (retval != PAPI_OK)
+            return retval;
+
+        symbol = name;
+        description.clear();
+        units.clear();
+        return PAPI_OK;
+    }
+
+    bool FastCounterRead() override
+    {
+        return true;
+    }
+
+    int Overflow(const int, const int, const int, PAPI_overflow_handler_t) override
+    {
+        return PAPI_ENOSUPP;
+    }
+
+    int GetOverflowEventIndex(const int, const long long, int *, int *) override
+    {
+        return PAPI_ENOSUPP;
+    }
+
+private:
+    /* Only the thread which created an event set uses it, so it needs no synchronization */
+    struct EventSet
+    {
+        std::vector<int> events;
+        std::vector<size_t> positions; // Next delta of the script of every event
+        std::vector<long long> values; // Counted since Start
+        bool running = false;
+    };
+
+    static int const maxGenerations = INT_MAX / PAPIW_SIMULATED_EVENT_SETS;
+
+    std::vector<EventSet *> eventSets;
+    std::vector<int> generations;  // Generation of every event set, which is part of its handle
+    std::vector<int> freeSets;     // Destroyed event sets, which are reused first
+    int usedSets = 0;              // Event sets which were ever created
+    std::mutex freeMutex;
+    std::map<int, std::vector<long long>> scripts;
+    std::vector<long long> defaultScript{1000};
+    std::set<int> unavailable;
+    std::map<long long, int> failures[static_cast<int>(Call::Count)]; // Return value by call number
+    std::atomic<long long> calls[static_cast<int>(Call::Count)] = {};
+    std::atomic<int> registeredThreads{0};
+    std::atomic<long long> realTime{0};
+    long long clockStep = 1000;
+    inline static thread_local long long virtTime = 0;
+
+    /* Count a call and return its scripted failure or PAPI_OK */
+    int fail(const Call call)
+    {
+        int index = static_cast<int>(call);
+        long long n = ++calls[index];
+        if (failures[index].empty())
+            return PAPI_OK;
+
+        auto failure = failures[index].find(n);
+        return failure != failures[index].end() ? failure->second : PAPI_OK;
+    }
+
+    EventSet *find(const int eventSet)
+    {
+        if (eventSet < 0)
+            return nullptr;
+        int index = eventSet % PAPIW_SIMULATED_EVENT_SETS;
+        if (generations[index] != eventSet / PAPIW_SIMULATED_EVENT_SETS)
+            return nullptr;
+        return eventSets[index];
+    }
+
+    /* Advance every event of a running event set by the next delta of its script */
+    void advance(EventSet &set)
+    {
+        int count = set.events.size();
+        for (int i = 0; i < count; i++)
+        {
+            auto script = scripts.find(set.events[i]);
+            auto &deltas = script != scripts.end() ? script->second : defaultScript;
+            set.values[i] += deltas[set.positions[i]++ % deltas.size()];
+        }
+    }
+};
+
+#endif
+#endif
@@ -0,0 +1,285 @@
+#ifndef PAPIWRAPPERTIMESERIES
+#define PAPIWRAPPERTIMESERIES
+#ifndef NOPAPIW
+
+#include <stdint.h>
+#include <stdio.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "./papiwrapperpapi.h"
+#include "./papiwrapperbackend.h"
+
+/* Number of samples a thread can hold until the writer thread flushes them. Has to be a power of two */
+#ifndef PAPIW_TIMESERIES_BUFFER_SIZE
+#define PAPIW_TIMESERIES_BUFFER_SIZE 1024
+#endif
+
+/* Real time signal used for the per-thread sampling timers */
+#ifndef PAPIW_TIMESERIES_SIGNAL
+#define PAPIW_TIMESERIES_SIGNAL (SIGRTMIN + 4)
+#endif
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+/**
+ * Periodic sampling of running counters
+ *
+ * Every thread whose counters are running gets a timer, which signals the thread itself at a fixed interval.
+ * The signal handler reads the counters of the thread with PAPI_read and pushes the values into a preallocated
+ * ring buffer of the thread. A low priority writer thread drains the ring buffers and writes the samples in
+ * batches to a CSV file with the columns: timestamp in ns, thread id and the counter values since the last Start.
+ *
+ * @note Only one instance may be active at a time. Destroy it only while no counters are running
+ */
+class PapiWrapperTimeSeries
+{
+private:
+    static uint32_t const bufferSize = PAPIW_TIMESERIES_BUFFER_SIZE;
+    static_assert((bufferSize & (bufferSize - 1)) == 0, "PAPIW_TIMESERIES_BUFFER_SIZE must be a power of two");
+
+    /* Samples of one thread. Written by the signal handler of the thread and read by the writer thread */
+    struct Series
+    {
+        pid_t threadId;
+        timer_t timer;
+        volatile sig_atomic_t eventSet = PAPI_NULL; // Event set which is currently running on the thread
+        volatile sig_atomic_t busy = 0;             // Set while the thread itself calls into Papi
+        const long long *volatile origin = nullptr; // Values at the last Start if the counters keep running, else nullptr
+        std::atomic<uint32_t> head{0};
+        std::atomic<uint32_t> tail{0};
+        std::atomic<long long> dropped{0};
+        std::vector<long long> records; // Timestamp followed by one value per event
+    };
+
+    inline static std::atomic<PapiWrapperTimeSeries *> active{nullptr};
+    inline static std::atomic<uint64_t> activeGeneration{0};
+    inline static thread_local Series *threadSeries = nullptr;
+    inline static thread_local uint64_t threadGeneration = 0;
+
+    const uint64_t generation;
+    const int eventCount;
+    const int stride;
+    const long long intervalNs;
+    FILE *file;
+    std::mutex seriesMutex;
+    std::vector<Series *> series;
+    std::vector<char> batch; // Preallocated text buffer of the writer thread
+    size_t batchUsed = 0;
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+
+public:
+    /**
+     * @param path File the samples are written to
+     * @param intervalNs Nanoseconds between two samples of a thread
+     * @param names Names of the counted events, used for the header of the file
+     */
+    PapiWrapperTimeSeries(const char *path, const long long intervalNs, const std::vector<std::string> &names)
+        : generation(++activeGeneration), eventCount(names.size()), stride(names.size() + 1),
+          intervalNs(intervalNs), batch(1 << 16)
+    {
+        file = fopen(path, "w");
+        if (file == nullptr)
+        {
+            fprintf(stderr, "PAPI ERROR in TimeSeries: Could not open %s\n", path);
+            exit(1);
+        }
+
+        fprintf(file, "timestamp_ns,thread");
+        for (auto &name : names)
+            fprintf(file, ",%s", name.c_str());
+        fprintf(file, "\n");
+
+        struct sigaction action = {};
+        action.sa_handler = signalHandler;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(PAPIW_TIMESERIES_SIGNAL, &action, nullptr);
+
+        writer = std::thread([this]() { write(); });
+        active = this;
+    }
+
+    /* Stops all timers and flushes the remaining samples. The counters should not be running anymore */
+    ~PapiWrapperTimeSeries()
+    {
+        /* Another instance may have been activated since, whose threads and signal handler stay untouched */
+        PapiWrapperTimeSeries *self = this;
+        bool wasActive = active.compare_exchange_strong(self, nullptr);
+        if (wasActive)
+            activeGeneration++;
+        stopping = true;
+        writer.join();
+
+        std::lock_guard<std::mutex> lock(seriesMutex);
+        for (auto s : series)
+            timer_delete(s->timer);
+        if (wasActive)
+            signal(PAPIW_TIMESERIES_SIGNAL, SIG_IGN);
+
+        flush();
+        fclose(file);
+        for (auto s : series)
+            delete s;
+    }
+
+    /**
+     * Sample the running event set of the calling thread from now on, if a time series is active
+     *
+     * @param origin If not nullptr, the counter values at Start, which are subtracted from every sample.
+     *               Needed if the counters were not restarted. Must stay valid until Detach
+     */
+    static void Attach(const int eventSet, const long long *origin = nullptr)
+    {
+        PapiWrapperTimeSeries *timeSeries = active.load(std::memory_order_acquire);
+        if (timeSeries == nullptr)
+            return;
+        if (threadGeneration != timeSeries->generation || threadSeries == nullptr)
+            timeSeries->registerThread();
+        threadSeries->origin = origin;
+        threadSeries->eventSet = eventSet;
+    }
+
+    /* Stop sampling the calling thread, e.g. before its counters are stopped */
+    static void Detach()
+    {
+        if (threadSeries != nullptr && threadGeneration == activeGeneration)
+            threadSeries->eventSet = PAPI_NULL;
+    }
+
+    /* Mark that the calling thread itself is calling into Papi, s.t. the signal handler does not interfere */
+    static void SetBusy(const bool busy)
+    {
+        if (threadSeries != nullptr && threadGeneration == activeGeneration)
+            threadSeries->busy = busy;
+    }
+
+    /* Number of samples which did not fit into the ring buffers */
+    long long Dropped()
+    {
+        std::lock_guard<std::mutex> lock(seriesMutex);
+        long long dropped = 0;
+        for (auto s : series)
+            dropped += s->dropped.load();
+        return dropped;
+    }
+
+private:
+    /* Create the series and the timer of the calling thread */
+    void registerThread()
+    {
+        auto s = new Series();
+        s->threadId = syscall(SYS_gettid);
+        s->records.resize(bufferSize * stride);
+
+        struct sigevent event = {};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = PAPIW_TIMESERIES_SIGNAL;
+        event.sigev_notify_thread_id = s->threadId;
+        if (timer_create(CLOCK_MONOTONIC, &event, &s->timer) != 0)
+        {
+            fprintf(stderr, "PAPI ERROR in TimeSeries: Could not create the sampling timer\n");
+            exit(1);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(seriesMutex);
+            series.push_back(s);
+        }
+        threadSeries = s;
+        threadGeneration = generation;
+
+        struct itimerspec interval = {};
+        interval.it_interval.tv_sec = intervalNs / 1000000000;
+        interval.it_interval.tv_nsec = intervalNs % 1000000000;
+        interval.it_value = interval.it_interval;
+        timer_settime(s->timer, 0, &interval, nullptr);
+    }
+
+    /* Read the counters of the interrupted thread into its ring buffer */
+    static void signalHandler(int)
+    {
+        Series *s = threadSeries;
+        if (s == nullptr || threadGeneration != activeGeneration || s->busy || s->eventSet == PAPI_NULL)
+            return;
+
+        uint32_t position = s->head.load(std::memory_order_relaxed);
+        if (position - s->tail.load(std::memory_order_acquire) == bufferSize)
+        {
+            s->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        int stride = s->records.size() / bufferSize;
+        long long *record = &s->records[(position & (bufferSize - 1)) * stride];
+        record[0] = PapiWrapperBackend::Get().GetRealNsec();
+        if (PapiWrapperBackend::Get().Read(s->eventSet, record + 1) != PAPI_OK)
+            return;
+        if (s->origin != nullptr)
+            for (int i = 1; i < stride; i++)
+                record[i] -= s->origin[i - 1];
+        s->head.store(position + 1, std::memory_order_release);
+    }
+
+    /* Main loop of the writer thread */
+    void write()
+    {
+        /* The writer must not take cpu time away from the measured threads */
+        struct sched_param parameter = {};
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &parameter);
+
+        /* Wake up often enough that a ring buffer is at most half full */
+        auto period = std::chrono::nanoseconds(std::max(1000000LL, std::min(1000000000LL, intervalNs * bufferSize / 2)));
+        while (!stopping)
+        {
+            std::this_thread::sleep_for(period);
+            std::lock_guard<std::mutex> lock(seriesMutex);
+            flush();
+        }
+    }
+
+    /* Write all samples of all threads. The caller has to hold seriesMutex */
+    void flush()
+    {
+        for (auto s : series)
+        {
+            uint32_t position = s->tail.load(std::memory_order_relaxed);
+            uint32_t end = s->head.load(std::memory_order_acquire);
+            for (; position != end; position++)
+            {
+                /* Keep room for a full line */
+                if (batch.size() - batchUsed < static_cast<size_t>(32 * (stride + 1)))
+                    writeBatch();
+
+                const long long *record = &s->records[(position & (bufferSize - 1)) * stride];
+                batchUsed += snprintf(&batch[batchUsed], batch.size() - batchUsed, "%lld,%d", record[0], s->threadId);
+                for (int i = 0; i < eventCount; i++)
+                    batchUsed += snprintf(&batch[batchUsed], batch.size() - batchUsed, ",%lld", record[i + 1]);
+                batch[batchUsed++] = '\n';
+            }
+            s->tail.store(position, std::memory_order_release);
+        }
+        writeBatch();
+    }
+
+    void writeBatch()
+    {
+        fwrite(batch.data(), 1, batchUsed, file);
+        batchUsed = 0;
+    }
+};
+
+#endif
+#endif
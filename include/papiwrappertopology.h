@@ -0,0 +1,138 @@
+#ifndef PAPIWRAPPERTOPOLOGY
+#define PAPIWRAPPERTOPOLOGY
+
+#include <dirent.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sysinfo.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/* Root of the sysfs directories cpu and node. Can be overridden at run time with the environment variable PAPIW_TOPOLOGY_ROOT */
+#ifndef PAPIW_TOPOLOGY_ROOT
+#define PAPIW_TOPOLOGY_ROOT "/sys/devices/system"
+#endif
+
+/**
+ * Socket, core and NUMA node of every logical cpu, read once from sysfs
+ *
+ * Cpus without topology information, e.g. in containers which hide sysfs, are assigned to socket 0,
+ * node 0 and a core of their own. Unknown cpus, e.g. -1 if sched_getcpu failed, are on socket 0 and share
+ * the core UnknownCore, s.t. they are never mixed up with a real core.
+ */
+class PapiWrapperTopology
+{
+public:
+    /* Core of the cpus which are not known, e.g. -1 */
+    static int const UnknownCore = -1;
+
+    /* A core is identified by its socket and the core id within the socket */
+    struct Cpu
+    {
+        int socket = 0;
+        int core = 0;
+        int node = 0;
+    };
+
+    /* @param root Root of the sysfs tree or nullptr for PAPIW_TOPOLOGY_ROOT */
+    explicit PapiWrapperTopology(const char *root = nullptr)
+    {
+        if (root == nullptr)
+            root = getenv("PAPIW_TOPOLOGY_ROOT");
+        if (root == nullptr)
+            root = PAPIW_TOPOLOGY_ROOT;
+
+        int count = get_nprocs_conf();
+        cpus.resize(count);
+        for (int cpu = 0; cpu < count; cpu++)
+        {
+            std::string path = std::string(root) + "/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            cpus[cpu].socket = std::max(readNumber(path + "physical_package_id", 0), 0);
+            cpus[cpu].core = readNumber(path + "core_id", cpu);
+        }
+
+        /* Node ids may be sparse and larger than the number of cpus */
+        std::string nodes = std::string(root) + "/node";
+        DIR *directory = opendir(nodes.c_str());
+        for (dirent *entry = directory != nullptr ? readdir(directory) : nullptr; entry != nullptr; entry = readdir(directory))
+        {
+            int node;
+            char rest;
+            if (sscanf(entry->d_name, "node%d%c", &node, &rest) != 1)
+                continue;
+            for (auto cpu : parseList(readLine(nodes + "/" + entry->d_name + "/cpulist")))
+                if (cpu < count)
+                    cpus[cpu].node = node;
+        }
+        if (directory != nullptr)
+            closedir(directory);
+    }
+
+    /* Get the placement of a cpu. Unknown cpus, e.g. -1 if sched_getcpu failed, are on socket 0 and UnknownCore */
+    const Cpu &Get(const int cpu) const
+    {
+        static const Cpu unknown{0, UnknownCore, 0};
+        return cpu >= 0 && cpu < static_cast<int>(cpus.size()) ? cpus[cpu] : unknown;
+    }
+
+    /* Number of logical cpus */
+    int Size() const
+    {
+        return cpus.size();
+    }
+
+    /* The cpu the calling thread is running on or -1 */
+    static int CurrentCpu()
+    {
+        return sched_getcpu();
+    }
+
+private:
+    std::vector<Cpu> cpus;
+
+    /* Read the first line of a file, empty if it is not readable */
+    static std::string readLine(const std::string &path)
+    {
+        char line[4096] = {};
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr)
+            return "";
+        if (fgets(line, sizeof(line), file) == nullptr)
+            line[0] = '\0';
+        fclose(file);
+        line[strcspn(line, "\n")] = '\0';
+        return line;
+    }
+
+    static int readNumber(const std::string &path, const int fallback)
+    {
+        std::string line = readLine(path);
+        return line.empty() ? fallback : atoi(line.c_str());
+    }
+
+    /* Parse a cpu list like 0-3,8-11 */
+    static std::vector<int> parseList(const std::string &list)
+    {
+        std::vector<int> result;
+        const char *position = list.c_str();
+        while (*position != '\0')
+        {
+            char *end;
+            int first = strtol(position, &end, 10);
+            if (end == position)
+                break;
+            int last = first;
+            if (*end == '-')
+                last = strtol(end + 1, &end, 10);
+            for (int cpu = first; cpu <= last; cpu++)
+                result.push_back(cpu);
+            position = *end == ',' ? end + 1 : end;
+        }
+        return result;
+    }
+};
+
+#endif
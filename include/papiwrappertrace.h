@@ -0,0 +1,480 @@
+#ifndef PAPIWRAPPERTRACE
+#define PAPIWRAPPERTRACE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/* Bytes a thread reserves at once in the trace file. Has to be a multiple of the page size */
+#ifndef PAPIW_TRACE_BLOCK_SIZE
+#define PAPIW_TRACE_BLOCK_SIZE (64 * 1024)
+#endif
+
+/* Number of blocks which are mapped at once */
+#ifndef PAPIW_TRACE_CHUNK_BLOCKS
+#define PAPIW_TRACE_CHUNK_BLOCKS 64
+#endif
+
+/* Maximum number of distinct regions per thread whose names are recorded. Has to be a power of two */
+#ifndef PAPIW_TRACE_MAX_REGIONS
+#define PAPIW_TRACE_MAX_REGIONS 256
+#endif
+
+/**
+ * Binary trace format
+ *
+ * A trace file consists of
+ *  - a Header followed by one Event per counted event, padded to dataOffset
+ *  - blocks of blockSize bytes filled with fixed size records. A record is a RecordHeader followed by one
+ *    counter delta per event. Unused records at the end of a block have a timestamp of zero
+ *  - the names of all regions as RegionEntry, followed by a Trailer at the very end of the file
+ *
+ * All values are stored in the byte order of the recording machine.
+ */
+namespace PAPIW
+{
+    namespace Trace
+    {
+        constexpr char Magic[8] = {'P', 'A', 'P', 'I', 'W', 'T', 'R', 'C'};
+        constexpr uint32_t Version = 1;
+
+        /* Region id of the intervals from starting to stopping the counters */
+        constexpr uint64_t IntervalRegion = 0;
+
+        /* Flag of the intervals in which the thread stopped on another cpu than it started on */
+        constexpr uint32_t RecordMigrated = 1;
+
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t eventCount;
+            uint32_t recordSize; // Bytes per record including the counter deltas
+            uint32_t blockSize;
+            uint64_t dataOffset; // Offset of the first block
+        };
+
+        struct Event
+        {
+            int32_t code;
+            char name[60];
+        };
+
+        struct RecordHeader
+        {
+            uint64_t timestamp; // Nanoseconds of CLOCK_MONOTONIC at the end of the interval
+            uint64_t region;    // Hash of the region name or IntervalRegion
+            uint32_t thread;    // Id of the kernel thread
+            uint32_t flags;     // RecordMigrated, zero for regions
+        };
+
+        struct RegionEntry
+        {
+            uint64_t region;
+            char name[56];
+        };
+
+        struct Trailer
+        {
+            uint64_t regionOffset;
+            uint64_t regionCount;
+            char magic[8];
+        };
+
+        constexpr size_t RecordSize(const uint32_t eventCount)
+        {
+            return sizeof(RecordHeader) + sizeof(int64_t) * eventCount;
+        }
+    } // namespace Trace
+} // namespace PAPIW
+
+/**
+ * Append-only writer of a binary trace
+ *
+ * The file is mapped into memory in chunks. Every thread reserves a block of the file and writes its records
+ * directly into the mapping, s.t. appending a record is a thread local copy of a few values.
+ * The lock is only taken when a thread needs a new block or records a region name for the first time.
+ *
+ * @note Only one instance may be active at a time. Destroy it only while no counters are running
+ */
+class PapiWrapperTrace
+{
+private:
+    static size_t const blockSize = PAPIW_TRACE_BLOCK_SIZE;
+    static size_t const chunkSize = PAPIW_TRACE_BLOCK_SIZE * PAPIW_TRACE_CHUNK_BLOCKS;
+    static int const regionTableSize = PAPIW_TRACE_MAX_REGIONS;
+    static_assert(blockSize % 4096 == 0, "PAPIW_TRACE_BLOCK_SIZE must be a multiple of the page size");
+    static_assert((regionTableSize & (regionTableSize - 1)) == 0, "PAPIW_TRACE_MAX_REGIONS must be a power of two");
+
+    /* Current block and known region names of one thread. Zero initialized as thread local */
+    struct Local
+    {
+        uint64_t generation;
+        uint32_t thread;
+        char *position;
+        char *end;
+        uint64_t regions[regionTableSize]; // Hashes whose names have been recorded, 0 for empty buckets
+    };
+
+    inline static std::atomic<PapiWrapperTrace *> active{nullptr};
+    inline static std::atomic<uint64_t> activeGeneration{0};
+    inline static thread_local Local local;
+
+    const uint64_t generation;
+    const int eventCount;
+    const size_t recordSize;
+    uint64_t dataOffset;
+    int file;
+    std::mutex mutex;
+    std::vector<char *> chunks;
+    uint64_t nextBlock = 0;
+    std::unordered_map<uint64_t, std::string> regionNames;
+
+public:
+    /**
+     * @param path File the trace is written to
+     * @param codes Event codes which are counted
+     * @param names Names of the events, in the same order
+     */
+    PapiWrapperTrace(const char *path, const std::vector<int> &codes, const std::vector<std::string> &names)
+        : generation(++activeGeneration), eventCount(codes.size()), recordSize(PAPIW::Trace::RecordSize(codes.size()))
+    {
+        if (recordSize > blockSize)
+            fail("Too many events for PAPIW_TRACE_BLOCK_SIZE");
+
+        file = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (file == -1)
+            fail("Could not open the trace file");
+
+        /* Header and events, padded to the page size s.t. the blocks can be mapped */
+        size_t headerSize = sizeof(PAPIW::Trace::Header) + sizeof(PAPIW::Trace::Event) * eventCount;
+        dataOffset = (headerSize + 4095) / 4096 * 4096;
+        std::vector<char> header(dataOffset, 0);
+
+        PAPIW::Trace::Header head = {};
+        memcpy(head.magic, PAPIW::Trace::Magic, sizeof(head.magic));
+        head.version = PAPIW::Trace::Version;
+        head.eventCount = eventCount;
+        head.recordSize = recordSize;
+        head.blockSize = blockSize;
+        head.dataOffset = dataOffset;
+        memcpy(header.data(), &head, sizeof(head));
+        for (int i = 0; i < eventCount; i++)
+        {
+            PAPIW::Trace::Event event = {};
+            event.code = codes[i];
+            strncpy(event.name, names[i].c_str(), sizeof(event.name) - 1);
+            memcpy(header.data() + sizeof(head) + sizeof(event) * i, &event, sizeof(event));
+        }
+        if (pwrite(file, header.data(), header.size(), 0) != static_cast<ssize_t>(header.size()))
+            fail("Could not write the trace header");
+
+        active = this;
+    }
+
+    /* Unmap the file and append the region names */
+    ~PapiWrapperTrace()
+    {
+        /* Another instance may have been activated since */
+        PapiWrapperTrace *self = this;
+        active.compare_exchange_strong(self, nullptr);
+        activeGeneration++;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto chunk : chunks)
+            munmap(chunk, chunkSize);
+
+        /* Cut off the blocks of the last chunk which were never reserved */
+        uint64_t regionOffset = dataOffset + nextBlock * blockSize;
+        if (ftruncate(file, regionOffset) != 0)
+            fail("Could not truncate the trace file");
+
+        std::vector<PAPIW::Trace::RegionEntry> entries;
+        entries.push_back({PAPIW::Trace::IntervalRegion, "interval"});
+        for (auto &region : regionNames)
+        {
+            PAPIW::Trace::RegionEntry entry = {};
+            entry.region = region.first;
+            strncpy(entry.name, region.second.c_str(), sizeof(entry.name) - 1);
+            entries.push_back(entry);
+        }
+
+        PAPIW::Trace::Trailer trailer = {};
+        trailer.regionOffset = regionOffset;
+        trailer.regionCount = entries.size();
+        memcpy(trailer.magic, PAPIW::Trace::Magic, sizeof(trailer.magic));
+
+        size_t size = sizeof(PAPIW::Trace::RegionEntry) * entries.size();
+        if (pwrite(file, entries.data(), size, regionOffset) != static_cast<ssize_t>(size) ||
+            pwrite(file, &trailer, sizeof(trailer), regionOffset + size) != static_cast<ssize_t>(sizeof(trailer)))
+            fail("Could not write the region names");
+        close(file);
+    }
+
+    PapiWrapperTrace(const PapiWrapperTrace &) = delete;
+    PapiWrapperTrace &operator=(const PapiWrapperTrace &) = delete;
+
+    /**
+     * Append a record to the active trace of the calling thread. Does nothing if no trace is active
+     *
+     * @param region Hash of the region name or PAPIW::Trace::IntervalRegion
+     * @param name Name of the region, recorded on first use. Must outlive the trace
+     * @param values count counter values
+     * @param base If not nullptr, the values at the begin of the interval, which are subtracted
+     * @param flags Flags of the record, e.g. PAPIW::Trace::RecordMigrated
+     */
+    static void Append(const uint64_t region, const char *name, const long long *values, const int count, const long long *base = nullptr,
+                       const uint32_t flags = 0)
+    {
+        PapiWrapperTrace *trace = active.load(std::memory_order_acquire);
+        if (trace == nullptr)
+            return;
+        trace->append(region, name, values, count, base, flags);
+    }
+
+private:
+    void append(const uint64_t region, const char *name, const long long *values, const int count, const long long *base, const uint32_t flags)
+    {
+        if (local.generation != generation)
+        {
+            local.generation = generation;
+            local.thread = syscall(SYS_gettid);
+            local.position = local.end = nullptr;
+            std::fill(local.regions, local.regions + regionTableSize, 0);
+        }
+        if (local.position == local.end)
+            reserveBlock();
+        if (region != PAPIW::Trace::IntervalRegion)
+            recordName(region, name);
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        auto record = reinterpret_cast<PAPIW::Trace::RecordHeader *>(local.position);
+        auto deltas = reinterpret_cast<int64_t *>(local.position + sizeof(PAPIW::Trace::RecordHeader));
+        int known = std::min(count, eventCount);
+        for (int i = 0; i < known; i++)
+            deltas[i] = base == nullptr ? values[i] : values[i] - base[i];
+        record->region = region;
+        record->thread = local.thread;
+        record->flags = flags;
+        record->timestamp = now.tv_sec * 1000000000ull + now.tv_nsec;
+        local.position += recordSize;
+    }
+
+    /* Give the calling thread a new block, mapping a new chunk of the file if needed */
+    void reserveBlock()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t block = nextBlock++;
+        size_t chunk = block / PAPIW_TRACE_CHUNK_BLOCKS;
+        if (chunk == chunks.size())
+        {
+            off_t offset = dataOffset + chunk * chunkSize;
+            if (ftruncate(file, offset + chunkSize) != 0)
+                fail("Could not grow the trace file");
+            void *memory = mmap(nullptr, chunkSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, offset);
+            if (memory == MAP_FAILED)
+                fail("Could not map the trace file");
+            chunks.push_back(static_cast<char *>(memory));
+        }
+
+        local.position = chunks[chunk] + (block % PAPIW_TRACE_CHUNK_BLOCKS) * blockSize;
+        local.end = local.position + blockSize / recordSize * recordSize;
+    }
+
+    /* Remember the name of a region the first time the calling thread records it */
+    void recordName(const uint64_t region, const char *name)
+    {
+        for (int probe = 0; probe < regionTableSize; probe++)
+        {
+            uint64_t &bucket = local.regions[(region + probe) & (regionTableSize - 1)];
+            if (bucket == region)
+                return;
+            if (bucket == 0)
+            {
+                bucket = region;
+                std::lock_guard<std::mutex> lock(mutex);
+                regionNames.emplace(region, name);
+                return;
+            }
+        }
+    }
+
+    static void fail(const char *msg)
+    {
+        fprintf(stderr, "PAPI ERROR in Trace: %s\n", msg);
+        exit(1);
+    }
+};
+
+/**
+ * Sequential reader of a binary trace
+ *
+ * The records are streamed block by block, s.t. traces larger than the memory can be processed.
+ */
+class PapiWrapperTraceReader
+{
+private:
+    FILE *file = nullptr;
+    PAPIW::Trace::Header header = {};
+    std::vector<int> codes;
+    std::vector<std::string> names;
+    std::unordered_map<uint64_t, std::string> regionNames;
+    uint64_t dataEnd = 0;
+    uint64_t blockOffset = 0; // Offset of the next block to read
+    std::vector<char> block;
+    size_t position = 0; // Offset of the next record in block
+    size_t blockUsed = 0;
+
+public:
+    ~PapiWrapperTraceReader()
+    {
+        if (file != nullptr)
+            fclose(file);
+    }
+
+    /* Read the header and region names of a trace. Returns false with a message if the file is no valid trace */
+    bool Open(const char *path, std::string &error)
+    {
+        file = fopen(path, "rb");
+        if (file == nullptr)
+        {
+            error = "Could not open the file";
+            return false;
+        }
+        if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, PAPIW::Trace::Magic, sizeof(header.magic)) != 0)
+        {
+            error = "Not a PAPIW trace";
+            return false;
+        }
+        if (header.version != PAPIW::Trace::Version)
+        {
+            error = "Unsupported trace version " + std::to_string(header.version);
+            return false;
+        }
+        if (header.recordSize != PAPIW::Trace::RecordSize(header.eventCount) || header.recordSize > header.blockSize)
+        {
+            error = "Corrupted trace header";
+            return false;
+        }
+
+        for (uint32_t i = 0; i < header.eventCount; i++)
+        {
+            PAPIW::Trace::Event event;
+            if (fread(&event, sizeof(event), 1, file) != 1)
+            {
+                error = "Truncated event list";
+                return false;
+            }
+            event.name[sizeof(event.name) - 1] = '\0';
+            codes.push_back(event.code);
+            names.push_back(event.name);
+        }
+
+        /* Without a trailer, e.g. after a crash, all blocks are read and regions are only known by their id */
+        PAPIW::Trace::Trailer trailer;
+        fseek(file, 0, SEEK_END);
+        dataEnd = ftell(file);
+        if (dataEnd >= header.dataOffset + sizeof(trailer) &&
+            fseek(file, dataEnd - sizeof(trailer), SEEK_SET) == 0 &&
+            fread(&trailer, sizeof(trailer), 1, file) == 1 &&
+            memcmp(trailer.magic, PAPIW::Trace::Magic, sizeof(trailer.magic)) == 0)
+        {
+            dataEnd = trailer.regionOffset;
+            fseek(file, trailer.regionOffset, SEEK_SET);
+            for (uint64_t i = 0; i < trailer.regionCount; i++)
+            {
+                PAPIW::Trace::RegionEntry entry;
+                if (fread(&entry, sizeof(entry), 1, file) != 1)
+                {
+                    error = "Truncated region names";
+                    return false;
+                }
+                entry.name[sizeof(entry.name) - 1] = '\0';
+                regionNames[entry.region] = entry.name;
+            }
+        }
+        else
+            regionNames[PAPIW::Trace::IntervalRegion] = "interval";
+
+        blockOffset = header.dataOffset;
+        block.resize(header.blockSize);
+        return true;
+    }
+
+    /* Event codes of the trace */
+    const std::vector<int> &Codes() const
+    {
+        return codes;
+    }
+
+    /* Event names of the trace */
+    const std::vector<std::string> &Names() const
+    {
+        return names;
+    }
+
+    /* Name of a region, or its id if the name is unknown */
+    std::string RegionName(const uint64_t region) const
+    {
+        auto name = regionNames.find(region);
+        if (name != regionNames.end())
+            return name->second;
+
+        char text[32];
+        snprintf(text, sizeof(text), "0x%016llx", static_cast<unsigned long long>(region));
+        return text;
+    }
+
+    /**
+     * Get the next record
+     *
+     * @param values Storage for one delta per event
+     * @return False at the end of the trace
+     */
+    bool Next(PAPIW::Trace::RecordHeader &record, long long *values)
+    {
+        while (true)
+        {
+            if (position + header.recordSize > blockUsed)
+            {
+                if (blockOffset >= dataEnd)
+                    return false;
+                fseek(file, blockOffset, SEEK_SET);
+                blockUsed = fread(block.data(), 1, std::min<uint64_t>(header.blockSize, dataEnd - blockOffset), file);
+                blockOffset += header.blockSize;
+                position = 0;
+                continue;
+            }
+
+            const char *data = block.data() + position;
+            position += header.recordSize;
+            memcpy(&record, data, sizeof(record));
+            if (record.timestamp == 0)
+                continue; // Unused record at the end of a block
+
+            for (uint32_t i = 0; i < header.eventCount; i++)
+            {
+                int64_t value;
+                memcpy(&value, data + sizeof(record) + sizeof(value) * i, sizeof(value));
+                values[i] = value;
+            }
+            return true;
+        }
+    }
+};
+
+#endif
@@ -4,12 +4,56 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <map>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
+#include <string>
 #include <iostream>
 #include <algorithm>
-#include <papi.h>
+#include "./papiwrapperpapi.h"
 #include <omp.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "./papiwrapperbackend.h"
+#include "./papiwrapperregions.h"
+#include "./papiwrappersamples.h"
+#include "./papiwrappertimeseries.h"
+#include "./papiwrappertrace.h"
+#include "./papiwrapperenergy.h"
+#include "./papiwrapperhistogram.h"
+#include "./papiwrappertopology.h"
+#include "./papiwrapperexport.h"
+#include "./papiwrappermetrics.h"
+#include "./papiwrapperdescriptions.h"
+#include "./papiwrapperplanner.h"
+
+/* Size of a cache line in bytes. Per-thread data is padded to it in order to avoid false sharing */
+#ifndef PAPIW_CACHE_LINE_SIZE
+#define PAPIW_CACHE_LINE_SIZE 64
+#endif
+
+/* Maximum number of threads of all nesting levels which are counted by one parallel instance */
+#ifndef PAPIW_MAX_THREADS
+#define PAPIW_MAX_THREADS 1024
+#endif
+
+/**
+ * Distribution of one event over all threads
+ */
+struct PapiWrapperStatistics
+{
+    long long min = 0;
+    long long max = 0;
+    double mean = 0;
+    double stddev = 0;
+    double imbalance = 0; // max / mean, 1 means perfectly balanced
+};
 
 /**
  * PapiWrapper abstract class
@@ -20,45 +64,505 @@
 class PapiWrapper
 {
 public:
-    virtual ~PapiWrapper() {}
+    virtual ~PapiWrapper()
+    {
+        delete timeSeries;
+        delete trace;
+        delete energy;
+        delete distribution;
+    }
 
     virtual void AddEvent(const int eventCode) = 0;
     virtual void Start() = 0;
     virtual void Stop() = 0;
     virtual long long GetResult(const int eventCode) = 0;
+
+    /* Copy the results of all events in the order of GetEvents() into results */
+    virtual void GetResults(long long *results) = 0;
     virtual void Print() = 0;
     virtual void Reset() = 0;
 
+    /* Get the value of a specific event for every thread */
+    virtual std::vector<long long> GetThreadResults(const int eventCode) = 0;
+
+    /* Get the result of a specific event for every OpenMP nesting level, starting with the outermost team */
+    virtual std::vector<long long> GetLevelResults(const int eventCode)
+    {
+        return {GetResult(eventCode)};
+    }
+
+    /* Get the result of a specific event for every socket, by the cpu the intervals were started on */
+    virtual std::vector<long long> GetSocketResults(const int eventCode)
+    {
+        return {GetResult(eventCode)};
+    }
+
+    /* Print the cpus and NUMA nodes the threads ran on, their migrations and the results per socket and core */
+    virtual void PrintPlacement()
+    {
+        issue_waring("PrintPlacement", "Only parallel instances record the cpus of their threads");
+    }
+
+    /* Print the values of every thread and their distribution */
+    virtual void PrintThreads() = 0;
+
+    /* Start measuring a named region. Regions may be nested */
+    virtual void BeginRegion(const PAPIW::RegionName &name) = 0;
+
+    /* Stop measuring the innermost named region */
+    virtual void EndRegion(const PAPIW::RegionName &name) = 0;
+
+    /* Get the result of a specific event inside a named region */
+    virtual long long GetRegionResult(const PAPIW::RegionName &name, const int eventCode) = 0;
+
+    /* Print the values of all named regions */
+    virtual void PrintRegions() = 0;
+
+    /* Print the inclusive and exclusive values of nested regions per call path */
+    virtual void PrintCallTree() = 0;
+
+    /* Record the instruction pointer whenever an event occurred threshold times */
+    virtual void EnableSampling(const int eventCode, const int threshold) = 0;
+
+    /* Print the functions and addresses with the most samples */
+    virtual void PrintSamples() = 0;
+
+    /**
+     * Measure the counts of empty Start/Stop pairs on every thread and store their median per event.
+     * Enables the correction of the results by this overhead
+     *
+     * @param repetitions Number of empty Start/Stop pairs per thread
+     */
+    virtual void Calibrate(const int repetitions) = 0;
+
+    /* Get the calibrated overhead of one Start/Stop pair, averaged over all threads */
+    virtual long long GetOverhead(const int eventCode) = 0;
+
+    /* Get the result of a specific event without the overhead correction */
+    virtual long long GetRawResult(const int eventCode) = 0;
+
+    /* Subtract the calibrated overhead times the number of intervals from the results */
+    virtual void CorrectOverhead(const bool enabled)
+    {
+        correctOverhead = enabled;
+    }
+
+    /**
+     * Keep the counters enabled and only read them in user space on Start, Stop and regions
+     *
+     * @return False if Papi can not read the counters with rdpmc. The counters are then started and stopped as before
+     */
+    virtual bool EnableFastRead() = 0;
+
+    /* Get the codes of the counted events */
+    virtual const std::vector<int> &GetEvents() = 0;
+
+    /* Get the nanoseconds the counters were running. For multiplexed events, the values are scaled to this time */
+    virtual long long GetEnabledTime() = 0;
+
+    /* Get the wall clock nanoseconds the counters were running */
+    virtual long long GetRealTime() = 0;
+
+    /* Get the cpu nanoseconds of all measured threads while the counters were running */
+    virtual long long GetVirtTime() = 0;
+
+    /**
+     * Write the values of the running counters of every thread periodically to a CSV file
+     *
+     * @param path File the samples are written to
+     * @param intervalNs Nanoseconds between two samples of a thread
+     */
+    void StartTimeSeries(const char *path, const long long intervalNs)
+    {
+        if (intervalNs <= 0)
+            handle_error("StartTimeSeries", "The sampling interval has to be positive");
+
+        delete timeSeries;
+        std::vector<std::string> names;
+        for (auto eventCode : GetEvents())
+            names.push_back(getName(eventCode));
+        timeSeries = new PapiWrapperTimeSeries(path, intervalNs, names);
+    }
+
+    /* Stop the periodic sampling and flush the remaining samples to the file */
+    void StopTimeSeries()
+    {
+        if (timeSeries == nullptr)
+            return;
+
+        long long dropped = timeSeries->Dropped();
+        if (dropped != 0)
+            issue_waring("StopTimeSeries", (std::to_string(dropped) + " samples were dropped. Increase PAPIW_TIMESERIES_BUFFER_SIZE").c_str());
+        delete timeSeries;
+        timeSeries = nullptr;
+    }
+
+    /* Record every interval between Start and Stop and every named region into a binary trace file */
+    void StartTrace(const char *path)
+    {
+        std::vector<std::string> names;
+        for (auto eventCode : GetEvents())
+            names.push_back(getName(eventCode));
+
+        delete trace;
+        trace = new PapiWrapperTrace(path, GetEvents(), names);
+    }
+
+    /* Stop recording and complete the trace file */
+    void StopTrace()
+    {
+        delete trace;
+        trace = nullptr;
+    }
+
+    /**
+     * Measure the energy of the RAPL zones in the intervals and in every named region
+     *
+     * @param root Root of the powercap sysfs tree or nullptr for PAPIW_ENERGY_ROOT
+     */
+    void EnableEnergy(const char *root)
+    {
+        delete energy;
+        energy = nullptr;
+        energy = new PapiWrapperEnergy(root);
+        if (energy->Zones().empty())
+            issue_waring("EnableEnergy", "No readable RAPL zone found, energy_uj usually needs root privileges");
+    }
+
+    /* Get the names of the measured RAPL zones, e.g. package-0 and package-0/dram */
+    std::vector<std::string> GetEnergyZones()
+    {
+        return energy != nullptr ? energy->Zones() : std::vector<std::string>();
+    }
+
+    /* Get the joules of every zone in the intervals, or in a named region */
+    std::vector<double> GetEnergy(const uint64_t region = PapiWrapperEnergy::IntervalRegion)
+    {
+        return energy != nullptr ? energy->GetJoules(region) : std::vector<double>();
+    }
+
+    /* Forget the energy measured so far */
+    void ResetEnergy()
+    {
+        if (energy != nullptr)
+            energy->Reset();
+    }
+
+    /* Record the values of every interval and every region instance into per thread histograms. Call it after adding the events */
+    void EnableDistribution()
+    {
+        delete distribution;
+        distribution = nullptr;
+        distribution = new PapiWrapperDistribution(GetEvents().size());
+    }
+
+    /**
+     * Get a percentile of the values of an event per interval, or per instance of a named region
+     *
+     * @param percentile Percentile between 0 and 100, e.g. 99.9
+     * @return The upper bound of the histogram bucket of the percentile, 0 if nothing was recorded
+     */
+    long long GetPercentile(const int eventCode, const double percentile, const uint64_t region = PapiWrapperDistribution::IntervalRegion)
+    {
+        auto &events = GetEvents();
+        auto event = std::find(events.begin(), events.end(), eventCode);
+        if (distribution == nullptr || event == events.end())
+            return 0;
+
+        for (auto &merged : distribution->Merge())
+            if (merged.id == region)
+                return merged.events[event - events.begin()].Percentile(percentile);
+        return 0;
+    }
+
+    /* Forget the recorded distributions */
+    void ResetDistribution()
+    {
+        if (distribution != nullptr)
+            distribution->Reset();
+    }
+
+    /* Print p50, p90, p99, p99.9 and the maximum of every event in the intervals and in every named region */
+    void PrintDistribution()
+    {
+        if (distribution == nullptr)
+        {
+            issue_waring("PrintDistribution", "The distribution is not enabled");
+            return;
+        }
+        printDistribution();
+    }
+
+    /* Write the results in the format of an exporter to a file. The file is replaced atomically */
+    void Export(PapiWrapperExporter &exporter, const char *path)
+    {
+        formatReport(exporter);
+
+        std::string temporary = std::string(path) + ".tmp";
+        FILE *file = fopen(temporary.c_str(), "w");
+        if (file == nullptr)
+            handle_error("Export", "Could not open the output file");
+        auto &buffer = getOutput().buffer;
+        bool written = fwrite(buffer.Data(), 1, buffer.Size(), file) == buffer.Size();
+        if (fclose(file) != 0 || !written || rename(temporary.c_str(), path) != 0)
+            handle_error("Export", "Could not write the output file");
+    }
+
+    /**
+     * Write the results in the format of an exporter to a buffer of the caller
+     *
+     * @return The length of the output. If it is not smaller than size, the output was truncated
+     */
+    size_t Export(PapiWrapperExporter &exporter, char *buffer, const size_t size)
+    {
+        formatReport(exporter);
+        auto &formatted = getOutput().buffer;
+        if (size != 0)
+        {
+            size_t length = std::min(formatted.Size(), size - 1);
+            memcpy(buffer, formatted.Data(), length);
+            buffer[length] = '\0';
+        }
+        return formatted.Size();
+    }
+
+    /**
+     * Additionally export the results to a file whenever Print is called
+     *
+     * @param replacePrint If true, Print does not write the human readable text to stdout anymore
+     */
+    void ExportOnPrint(PapiWrapperExporter &exporter, const char *path, const bool replacePrint)
+    {
+        getOutput().printExporters.push_back({&exporter, path});
+        printText = printText && !replacePrint;
+    }
+
+    /* Get min, max, mean, standard deviation and load imbalance of an event over all threads */
+    PapiWrapperStatistics GetStatistics(const int eventCode)
+    {
+        return computeStatistics(GetThreadResults(eventCode));
+    }
+
     /**
      * Default 
      *
-     * @tparam PapiCodes a variadic list of PAPI eventcodes
+     * @tparam PapiEvents a variadic list of PAPI eventcodes or event names, e.g. "perf::CONTEXT-SWITCHES"
      * @warning Exits with an error if called in a parallel region
      */
-    template <typename... PapiCodes>
-    void Init(PapiCodes const... eventcodes)
+    template <typename... PapiEvents>
+    void Init(PapiEvents const... events)
     {
-        /* Initialize the PAPI library */
-        retval = PAPI_library_init(PAPI_VER_CURRENT);
-        if (retval != PAPI_VER_CURRENT)
-            handle_error("Init", "PAPI library init error!\n", retval);
-
-        /* Some more initialization inside the specialization classes*/
-        localInit();
+        initLibrary();
 
         /* Prepare Events */
-        static_assert(std::conjunction<std::is_integral<PapiCodes>...>(),
-                      "All parameters to Init must be of integral type");
-        int args[]{eventcodes...}; //unpack
-        for (auto eventcode : args)
-            AddEvent(eventcode);
+        static_assert(std::conjunction<std::disjunction<std::is_integral<PapiEvents>, std::is_convertible<PapiEvents, std::string>>...>(),
+                      "All parameters to Init must be event codes or event names");
+        (addEvent(events), ...);
+        initEvents();
+    }
+
+    /* Same as Init, but with event names which are only known at runtime, e.g. from the environment */
+    void Init(const std::vector<std::string> &names)
+    {
+        initLibrary();
+        for (auto &name : names)
+            addEvent(name);
+        initEvents();
+    }
+
+    /**
+     * Run a deterministic function while the counters are running. Wrappers which can not count all events
+     * at once run it once per group of events, otherwise it runs once
+     *
+     * @warning Exits with an error if called in a parallel region or while the counters are running
+     */
+    virtual void MeasurePasses(const std::function<void()> &function)
+    {
+        Start();
+        function();
+        Stop();
+    }
+
+    /* Get the symbol, description and units of a counted event or nullptr if it is not counted */
+    const PapiWrapperEventInfo *GetEventInfo(const int eventCode)
+    {
+        return eventTable.Find(eventCode);
+    }
+
+    /* Compute a metric from the counted events. Warns and ignores the metric if not all its events are counted */
+    void AddMetric(const PapiWrapperMetric &metric)
+    {
+        if (!metrics.Add(metric, GetEvents()))
+            issue_waring("AddMetric. Not all events are counted for", metric.name.c_str());
+    }
+
+    /* Get the value of a derived metric, NaN if it is undefined */
+    double GetMetric(const std::string &name)
+    {
+        int metric = metrics.Find(name);
+        if (metric == -1)
+            handle_error("GetMetric", "The metric is unknown or not all its events are counted");
+
+        std::vector<long long> totals;
+        for (auto eventCode : GetEvents())
+            totals.push_back(GetResult(eventCode));
+        return metrics.Compute(metric, totals.data(), GetRealTime(), GetVirtTime());
+    }
+
+    /* Getter Method for the multiplexed mode */
+    bool IsMultiplexed()
+    {
+        return multiplexed;
     }
 
 protected:
+    friend class PapiWrapperPasses;
+
     int retval;
+    bool multiplexed = false; // If true, the events share the hardware counters and the values are scaled estimates
+    PapiWrapperTimeSeries *timeSeries = nullptr;
+    PapiWrapperTrace *trace = nullptr;
+    PapiWrapperEnergy *energy = nullptr;
+    PapiWrapperDistribution *distribution = nullptr;
+    const char *mode = "";                  // Mode of the instance in the exported reports
+    std::unique_ptr<PapiWrapperOutput> output; // Created on the first export, the per thread instances never export
+    bool printText = true; // False if Print only runs the exporters
+    bool correctOverhead = false; // If true, the calibrated overhead of every interval is subtracted from the results
+    PapiWrapperMetrics metrics;
+    PapiWrapperEventTable eventTable;
+
+    PapiWrapper(const bool multiplexed = false) : multiplexed(multiplexed) {}
 
     virtual void localInit() {}
 
+    /* Prepare an instance which counts one pass of PapiWrapperPasses. The library is already initialized by its Init */
+    virtual void initPass()
+    {
+        localInit();
+    }
+
+    /* Called by Init once all events are added */
+    virtual void eventsAdded() {}
+
+    /* Initialize the PAPI library and the specialization classes */
+    void initLibrary()
+    {
+        retval = PapiWrapperBackend::Get().LibraryInit();
+        if (retval != PAPI_OK)
+            handle_error("Init", "PAPI library init error!\n", retval);
+
+        if (multiplexed)
+        {
+            retval = PapiWrapperBackend::Get().MultiplexInit();
+            if (retval != PAPI_OK)
+                handle_error("Init", "Could not initialize multiplexing", retval);
+        }
+
+        /* Some more initialization inside the specialization classes*/
+        localInit();
+    }
+
+    /* Finish Init once all events are added */
+    void initEvents()
+    {
+        eventsAdded();
+
+        /* Query the metadata once, s.t. printing and exporting do not need Papi */
+        eventTable.Build(GetEvents());
+
+        /* Derive every standard metric whose events could be added */
+        metrics.AddAvailable(PapiWrapperMetricCatalogue(), GetEvents());
+    }
+
+    /* Add an event by its code */
+    void addEvent(const int eventCode)
+    {
+        AddEvent(eventCode);
+    }
+
+    /* Add an event by its name. Unknown names are skipped with a warning */
+    void addEvent(const std::string &name)
+    {
+        int eventCode;
+        retval = PapiWrapperBackend::Get().EventNameToCode(name.c_str(), &eventCode);
+        if (retval != PAPI_OK)
+            issue_waring("Init. Unknown event", name.c_str(), retval);
+        else
+            AddEvent(eventCode);
+    }
+
+    /* Get the values of all named regions, summed up over all threads. Might be nullptr */
+    virtual const PapiWrapperRegions *getRegions() = 0;
+
+    /* Append the value of an event for every thread, in the order of GetThreadResults, without allocating once results is large enough */
+    virtual void appendThreadResults(const int eventCode, std::vector<long long> &results)
+    {
+        auto threadResults = GetThreadResults(eventCode);
+        results.insert(results.end(), threadResults.begin(), threadResults.end());
+    }
+
+    /* Get the export state, creating it on first use */
+    PapiWrapperOutput &getOutput()
+    {
+        if (output == nullptr)
+            output.reset(new PapiWrapperOutput());
+        return *output;
+    }
+
+    /* Collect the results and format them with an exporter into the buffer of the output */
+    void formatReport(PapiWrapperExporter &exporter)
+    {
+        auto &report = getOutput().report;
+        auto &events = GetEvents();
+        int count = events.size();
+        if (report.events != events)
+        {
+            report.events = events;
+            report.names.clear();
+            for (auto eventCode : events)
+                report.names.push_back(getName(eventCode));
+        }
+
+        report.mode = mode;
+        report.multiplexed = multiplexed;
+        report.enabledTime = GetEnabledTime();
+        report.totals.resize(count);
+        GetResults(report.totals.data());
+        report.threadValues.clear();
+        report.threads = 0;
+        for (auto eventCode : events)
+        {
+            size_t first = report.threadValues.size();
+            appendThreadResults(eventCode, report.threadValues);
+            report.threads = report.threadValues.size() - first;
+        }
+
+        report.regionNames.clear();
+        report.regionIntervals.clear();
+        report.regionValues.clear();
+        auto regions = getRegions();
+        for (int region = 0; regions != nullptr && region < regions->Size(); region++)
+        {
+            if (regions->Intervals(region) == 0)
+                continue;
+            report.regionNames.push_back(regions->Name(region));
+            report.regionIntervals.push_back(regions->Intervals(region));
+            report.regionValues.insert(report.regionValues.end(), regions->Values(region), regions->Values(region) + count);
+        }
+
+        output->buffer.Clear();
+        exporter.Format(report, output->buffer);
+    }
+
+    /* Run the exporters registered with ExportOnPrint */
+    void exportOnPrint()
+    {
+        if (output == nullptr)
+            return;
+        for (auto &exporter : output->printExporters)
+            Export(*exporter.first, exporter.second.c_str());
+    }
+
     /* Exit with an error message */
     void handle_error(const char *location, const char *msg, const int retval = PAPI_OK)
     {
@@ -89,9 +593,7 @@ protected:
         std::cout << "@%% ";
         for (auto eventCode : events)
         {
-            auto description = getDescription(eventCode);
-            for (int j = 0; description[j] != '\0' && description[j] != ' ' && j < 20; j++)
-                std::cout << description[j];
+            printName(eventCode);
             std::cout << " ";
         }
         std::cout << std::endl;
@@ -102,583 +604,3177 @@ protected:
         for (int i = 0; i < count; i++)
             std::cout << values[i] << " ";
         std::cout << std::endl;
+        printEnergy();
+        printDistribution();
     }
 
-    /* Get Descriptiion Text of event */
-    const char *getDescription(const int eventCode)
+    /* Print the energy of every RAPL zone in the intervals */
+    void printEnergy()
+    {
+        if (energy == nullptr)
+            return;
+
+        auto &zones = energy->Zones();
+        auto joules = energy->GetJoules();
+        std::cout << "Energy in joules:" << std::endl;
+        for (size_t zone = 0; zone < zones.size(); zone++)
+            std::cout << "  " << zones[zone] << ": " << joules[zone] << std::endl;
+
+        std::cout << "@%J ";
+        for (auto &zone : zones)
+            std::cout << zone << " ";
+        std::cout << std::endl;
+        std::cout << "@%j ";
+        for (auto value : joules)
+            std::cout << value << " ";
+        std::cout << std::endl;
+    }
+
+    /* Print the percentiles of every event in the intervals and in every named region */
+    void printDistribution()
+    {
+        if (distribution == nullptr)
+            return;
+
+        static const double percentiles[] = {50, 90, 99, 99.9};
+        auto &events = GetEvents();
+        auto regions = distribution->Merge();
+        for (auto &region : regions)
+        {
+            uint64_t instances = 0;
+            for (auto &histogram : region.events)
+                instances = std::max(instances, histogram.Count());
+            std::cout << region.name << " distribution (" << instances << " instances):" << std::endl;
+            for (size_t i = 0; i < events.size() && i < region.events.size(); i++)
+            {
+                std::cout << "  " << getDescription(events[i]) << ":";
+                for (auto percentile : percentiles)
+                    std::cout << " p" << percentile << " " << region.events[i].Percentile(percentile);
+                std::cout << " max " << region.events[i].Max() << std::endl;
+            }
+        }
+
+        std::cout << "@%H REGION EVENT COUNT P50 P90 P99 P99.9 MAX" << std::endl;
+        for (auto &region : regions)
+            for (size_t i = 0; i < events.size() && i < region.events.size(); i++)
+            {
+                std::cout << "@%h " << region.name << " ";
+                printName(events[i]);
+                std::cout << " " << region.events[i].Count() << " ";
+                for (auto percentile : percentiles)
+                    std::cout << region.events[i].Percentile(percentile) << " ";
+                std::cout << region.events[i].Max() << std::endl;
+            }
+    }
+
+    /* Print the energy of every RAPL zone in every named region */
+    void printRegionEnergy()
+    {
+        if (energy == nullptr)
+            return;
+
+        auto &zones = energy->Zones();
+        auto regions = energy->GetRegionJoules();
+        for (auto &region : regions)
+        {
+            std::cout << region.first << " energy in joules:" << std::endl;
+            for (size_t zone = 0; zone < zones.size(); zone++)
+                std::cout << "  " << zones[zone] << ": " << region.second[zone] << std::endl;
+        }
+
+        std::cout << "@%J REGION ";
+        for (auto &zone : zones)
+            std::cout << zone << " ";
+        std::cout << std::endl;
+        for (auto &region : regions)
+        {
+            std::cout << "@%K " << region.first << " ";
+            for (auto value : region.second)
+                std::cout << value << " ";
+            std::cout << std::endl;
+        }
+    }
+
+    /* Print the overhead which is subtracted per interval from the results */
+    void printOverhead(const std::vector<int> &events)
+    {
+        if (!correctOverhead)
+            return;
+
+        std::cout << "Corrected by the calibrated overhead of an empty start and stop per interval:" << std::endl;
+        for (auto eventCode : events)
+            std::cout << "  " << getDescription(eventCode) << ": " << GetOverhead(eventCode) << std::endl;
+        std::cout << "@%O ";
+        for (auto eventCode : events)
+            std::cout << GetOverhead(eventCode) << " ";
+        std::cout << std::endl;
+    }
+
+    /* Median of values, which are reordered */
+    static long long median(std::vector<long long> &values)
+    {
+        if (values.empty())
+            return 0;
+        auto middle = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), middle, values.end());
+        return *middle;
+    }
+
+    /* Print the derived metrics next to the values */
+    void printMetrics(const long long *values)
+    {
+        if (metrics.Size() == 0)
+            return;
+
+        long long realTime = GetRealTime();
+        long long virtTime = GetVirtTime();
+        std::cout << "Derived metrics (real time: " << realTime << " ns, virtual time: " << virtTime << " ns):" << std::endl;
+        for (int metric = 0; metric < metrics.Size(); metric++)
+        {
+            auto &definition = metrics.Get(metric);
+            std::cout << definition.name << " (" << definition.description << "): "
+                      << metrics.Compute(metric, values, realTime, virtTime) << std::endl;
+        }
+
+        std::cout << "@%M ";
+        for (int metric = 0; metric < metrics.Size(); metric++)
+            std::cout << metrics.Get(metric).name << " ";
+        std::cout << std::endl;
+        std::cout << "@%m ";
+        for (int metric = 0; metric < metrics.Size(); metric++)
+            std::cout << metrics.Compute(metric, values, realTime, virtTime) << " ";
+        std::cout << std::endl;
+    }
+
+    /**
+     * Print the enabled time of multiplexed events. Papi scales the values of multiplexed events by the
+     * ratio of the time they were enabled to the time they were actually running on a counter
+     */
+    void printMultiplexed(const std::vector<int> &events, const long long enabledTime)
+    {
+        std::cout << "Multiplexed events, the values are scaled estimates" << std::endl;
+        for (auto eventCode : events)
+        {
+            std::cout << "@%X ";
+            printName(eventCode);
+            std::cout << " " << GetResult(eventCode) << " " << enabledTime << std::endl;
+        }
+    }
+
+    /* Print a histogram of the sampled functions and addresses for every sampled event */
+    void printSamples(const PapiWrapperSamples &samples)
     {
-        switch (eventCode)
-        {
-        case PAPI_L1_DCM:
-            return "PAPI_L1_DCM (Level 1 data cache misses)";
-        case PAPI_L1_ICM:
-            return "PAPI_L1_ICM (Level 1 instruction cache misses)";
-        case PAPI_L2_DCM:
-            return "PAPI_L2_DCM (Level 2 data cache misses)";
-        case PAPI_L2_ICM:
-            return "PAPI_L2_ICM (Level 2 instruction cache misses)";
-        case PAPI_L3_DCM:
-            return "PAPI_L3_DCM (Level 3 data cache misses)";
-        case PAPI_L3_ICM:
-            return "PAPI_L3_ICM (Level 3 instruction cache misses)";
-        case PAPI_L1_TCM:
-            return "PAPI_L1_TCM (Level 1 total cache misses)";
-        case PAPI_L2_TCM:
-            return "PAPI_L2_TCM (Level 2 total cache misses)";
-        case PAPI_L3_TCM:
-            return "PAPI_L3_TCM (Level 3 total cache misses)";
-        case PAPI_CA_SNP:
-            return "PAPI_CA_SNP (Snoops)";
-        case PAPI_CA_SHR:
-            return "PAPI_CA_SHR (Request for shared cache line (SMP))";
-        case PAPI_CA_CLN:
-            return "PAPI_CA_CLN (Request for clean cache line (SMP))";
-        case PAPI_CA_INV:
-            return "PAPI_CA_INV (Request for cache line Invalidation (SMP))";
-        case PAPI_CA_ITV:
-            return "PAPI_CA_ITV (Request for cache line Intervention (SMP))";
-        case PAPI_L3_LDM:
-            return "PAPI_L3_LDM (Level 3 load misses)";
-        case PAPI_L3_STM:
-            return "PAPI_L3_STM (Level 3 store misses)";
-        case PAPI_BRU_IDL:
-            return "PAPI_BRU_IDL (Cycles branch units are idle)";
-        case PAPI_FXU_IDL:
-            return "PAPI_FXU_IDL (Cycles integer units are idle)";
-        case PAPI_FPU_IDL:
-            return "PAPI_FPU_IDL (Cycles floating point units are idle)";
-        case PAPI_LSU_IDL:
-            return "PAPI_LSU_IDL (Cycles load/store units are idle)";
-        case PAPI_TLB_DM:
-            return "PAPI_TLB_DM (Data translation lookaside buffer misses)";
-        case PAPI_TLB_IM:
-            return "PAPI_TLB_IM (Instr translation lookaside buffer misses)";
-        case PAPI_TLB_TL:
-            return "PAPI_TLB_TL (Total translation lookaside buffer misses)";
-        case PAPI_L1_LDM:
-            return "PAPI_L1_LDM (Level 1 load misses)";
-        case PAPI_L1_STM:
-            return "PAPI_L1_STM (Level 1 store misses)";
-        case PAPI_L2_LDM:
-            return "PAPI_L2_LDM (Level 2 load misses)";
-        case PAPI_L2_STM:
-            return "PAPI_L2_STM (Level 2 store misses)";
-        case PAPI_BTAC_M:
-            return "PAPI_BTAC_M (BTAC miss)";
-        case PAPI_PRF_DM:
-            return "PAPI_PRF_DM (Prefetch data instruction caused a miss)";
-        case PAPI_L3_DCH:
-            return "PAPI_L3_DCH (Level 3 Data Cache Hit)";
-        case PAPI_TLB_SD:
-            return "PAPI_TLB_SD (Xlation lookaside buffer shootdowns (SMP))";
-        case PAPI_CSR_FAL:
-            return "PAPI_CSR_FAL (Failed store conditional instructions)";
-        case PAPI_CSR_SUC:
-            return "PAPI_CSR_SUC (Successful store conditional instructions)";
-        case PAPI_CSR_TOT:
-            return "PAPI_CSR_TOT (Total store conditional instructions)";
-        case PAPI_MEM_SCY:
-            return "PAPI_MEM_SCY (Cycles Stalled Waiting for Memory Access)";
-        case PAPI_MEM_RCY:
-            return "PAPI_MEM_RCY (Cycles Stalled Waiting for Memory Read)";
-        case PAPI_MEM_WCY:
-            return "PAPI_MEM_WCY (Cycles Stalled Waiting for Memory Write)";
-        case PAPI_STL_ICY:
-            return "PAPI_STL_ICY (Cycles with No Instruction Issue)";
-        case PAPI_FUL_ICY:
-            return "PAPI_FUL_ICY (Cycles with Maximum Instruction Issue)";
-        case PAPI_STL_CCY:
-            return "PAPI_STL_CCY (Cycles with No Instruction Completion)";
-        case PAPI_FUL_CCY:
-            return "PAPI_FUL_CCY (Cycles with Maximum Instruction Completion)";
-        case PAPI_HW_INT:
-            return "PAPI_HW_INT (Hardware interrupts)";
-        case PAPI_BR_UCN:
-            return "PAPI_BR_UCN (Unconditional branch instructions executed)";
-        case PAPI_BR_CN:
-            return "PAPI_BR_CN (Conditional branch instructions executed)";
-        case PAPI_BR_TKN:
-            return "PAPI_BR_TKN (Conditional branch instructions taken)";
-        case PAPI_BR_NTK:
-            return "PAPI_BR_NTK (Conditional branch instructions not taken)";
-        case PAPI_BR_MSP:
-            return "PAPI_BR_MSP (Conditional branch instructions mispred)";
-        case PAPI_BR_PRC:
-            return "PAPI_BR_PRC (Conditional branch instructions corr. pred)";
-        case PAPI_FMA_INS:
-            return "PAPI_FMA_INS (FMA instructions completed)";
-        case PAPI_TOT_IIS:
-            return "PAPI_TOT_IIS (Total instructions issued)";
-        case PAPI_TOT_INS:
-            return "PAPI_TOT_INS (Total instructions executed)";
-        case PAPI_INT_INS:
-            return "PAPI_INT_INS (Integer instructions executed)";
-        case PAPI_FP_INS:
-            return "PAPI_FP_INS (Floating point instructions executed)";
-        case PAPI_LD_INS:
-            return "PAPI_LD_INS (Load instructions executed)";
-        case PAPI_SR_INS:
-            return "PAPI_SR_INS (Store instructions executed)";
-        case PAPI_BR_INS:
-            return "PAPI_BR_INS (Total branch instructions executed)";
-        case PAPI_VEC_INS:
-            return "PAPI_VEC_INS (Vector/SIMD instructions executed (could include integer))";
-        case PAPI_RES_STL:
-            return "PAPI_RES_STL (Cycles processor is stalled on resource)";
-        case PAPI_FP_STAL:
-            return "PAPI_FP_STAL (Cycles any FP units are stalled)";
-        case PAPI_TOT_CYC:
-            return "PAPI_TOT_CYC (Total cycles executed)";
-        case PAPI_LST_INS:
-            return "PAPI_LST_INS (Total load/store inst. executed)";
-        case PAPI_SYC_INS:
-            return "PAPI_SYC_INS (Sync. inst. executed)";
-        case PAPI_L1_DCH:
-            return "PAPI_L1_DCH (L1 D Cache Hit)";
-        case PAPI_L2_DCH:
-            return "PAPI_L2_DCH (L2 D Cache Hit)";
-        case PAPI_L1_DCA:
-            return "PAPI_L1_DCA (L1 D Cache Access)";
-        case PAPI_L2_DCA:
-            return "PAPI_L2_DCA (L2 D Cache Access)";
-        case PAPI_L3_DCA:
-            return "PAPI_L3_DCA (L3 D Cache Access)";
-        case PAPI_L1_DCR:
-            return "PAPI_L1_DCR (L1 D Cache Read)";
-        case PAPI_L2_DCR:
-            return "PAPI_L2_DCR (L2 D Cache Read)";
-        case PAPI_L3_DCR:
-            return "PAPI_L3_DCR (L3 D Cache Read)";
-        case PAPI_L1_DCW:
-            return "PAPI_L1_DCW (L1 D Cache Write)";
-        case PAPI_L2_DCW:
-            return "PAPI_L2_DCW (L2 D Cache Write)";
-        case PAPI_L3_DCW:
-            return "PAPI_L3_DCW (L3 D Cache Write)";
-        case PAPI_L1_ICH:
-            return "PAPI_L1_ICH (L1 instruction cache hits)";
-        case PAPI_L2_ICH:
-            return "PAPI_L2_ICH (L2 instruction cache hits)";
-        case PAPI_L3_ICH:
-            return "PAPI_L3_ICH (L3 instruction cache hits)";
-        case PAPI_L1_ICA:
-            return "PAPI_L1_ICA (L1 instruction cache accesses)";
-        case PAPI_L2_ICA:
-            return "PAPI_L2_ICA (L2 instruction cache accesses)";
-        case PAPI_L3_ICA:
-            return "PAPI_L3_ICA (L3 instruction cache accesses)";
-        case PAPI_L1_ICR:
-            return "PAPI_L1_ICR (L1 instruction cache reads)";
-        case PAPI_L2_ICR:
-            return "PAPI_L2_ICR (L2 instruction cache reads)";
-        case PAPI_L3_ICR:
-            return "PAPI_L3_ICR (L3 instruction cache reads)";
-        case PAPI_L1_ICW:
-            return "PAPI_L1_ICW (L1 instruction cache writes)";
-        case PAPI_L2_ICW:
-            return "PAPI_L2_ICW (L2 instruction cache writes)";
-        case PAPI_L3_ICW:
-            return "PAPI_L3_ICW (L3 instruction cache writes)";
-        case PAPI_L1_TCH:
-            return "PAPI_L1_TCH (L1 total cache hits)";
-        case PAPI_L2_TCH:
-            return "PAPI_L2_TCH (L2 total cache hits)";
-        case PAPI_L3_TCH:
-            return "PAPI_L3_TCH (L3 total cache hits)";
-        case PAPI_L1_TCA:
-            return "PAPI_L1_TCA (L1 total cache accesses)";
-        case PAPI_L2_TCA:
-            return "PAPI_L2_TCA (L2 total cache accesses)";
-        case PAPI_L3_TCA:
-            return "PAPI_L3_TCA (L3 total cache accesses)";
-        case PAPI_L1_TCR:
-            return "PAPI_L1_TCR (L1 total cache reads)";
-        case PAPI_L2_TCR:
-            return "PAPI_L2_TCR (L2 total cache reads)";
-        case PAPI_L3_TCR:
-            return "PAPI_L3_TCR (L3 total cache reads)";
-        case PAPI_L1_TCW:
-            return "PAPI_L1_TCW (L1 total cache writes)";
-        case PAPI_L2_TCW:
-            return "PAPI_L2_TCW (L2 total cache writes)";
-        case PAPI_L3_TCW:
-            return "PAPI_L3_TCW (L3 total cache writes)";
-        case PAPI_FML_INS:
-            return "PAPI_FML_INS (FM ins)";
-        case PAPI_FAD_INS:
-            return "PAPI_FAD_INS (FA ins)";
-        case PAPI_FDV_INS:
-            return "PAPI_FDV_INS (FD ins)";
-        case PAPI_FSQ_INS:
-            return "PAPI_FSQ_INS (FSq ins)";
-        case PAPI_FNV_INS:
-            return "PAPI_FNV_INS (Finv ins)";
-        case PAPI_FP_OPS:
-            return "PAPI_FP_OPS (Floating point operations executed)";
-        case PAPI_SP_OPS:
-            return "PAPI_SP_OPS (Floating point operations executed: optimized to count scaled single precision vector operations)";
-        case PAPI_DP_OPS:
-            return "PAPI_DP_OPS (Floating point operations executed: optimized to count scaled double precision vector operations)";
-        case PAPI_VEC_SP:
-            return "PAPI_VEC_SP (Single precision vector/SIMD instructions)";
-        case PAPI_VEC_DP:
-            return "PAPI_VEC_DP (Double precision vector/SIMD instructions)";
-        case PAPI_REF_CYC:
-            return "PAPI_REF_CYC (Reference clock cycles)";
-        default:
-            return "UNKNOWN CODE";
+        for (auto &event : samples.Histograms())
+        {
+            long long total = 0;
+            std::map<std::string, long long> functions;
+            std::vector<std::pair<std::string, long long>> addresses;
+            for (auto &address : event.second)
+            {
+                total += address.second;
+                functions[PapiWrapperSamples::Symbolize(address.first, false)] += address.second;
+
+                char text[32];
+                snprintf(text, sizeof(text), "%p", address.first);
+                addresses.push_back({std::string(text) + " " + PapiWrapperSamples::Symbolize(address.first, true), address.second});
+            }
+
+            std::cout << getDescription(event.first) << ": " << total << " samples" << std::endl;
+            std::cout << "  Top functions:" << std::endl;
+            printTopSamples(event.first, "@%S", {functions.begin(), functions.end()}, total);
+            std::cout << "  Top addresses:" << std::endl;
+            printTopSamples(event.first, "@%A", addresses, total);
+        }
+
+        if (samples.Dropped() != 0)
+            std::cout << samples.Dropped() << " samples were dropped. Check PAPIW_SAMPLE_BUFFER_SIZE" << std::endl;
+    }
+
+    /* Print the entries with the most samples, each as readable and as machine readable line */
+    void printTopSamples(const int eventCode, const char *prefix, std::vector<std::pair<std::string, long long>> entries, const long long total)
+    {
+        auto top = entries.begin() + std::min<size_t>(PAPIW_SAMPLE_TOP, entries.size());
+        std::partial_sort(entries.begin(), top, entries.end(),
+                          [](const auto &a, const auto &b) { return a.second > b.second; });
+
+        for (auto entry = entries.begin(); entry != top; entry++)
+        {
+            std::cout << "    " << 100.0 * entry->second / total << "% " << entry->second << " " << entry->first << std::endl;
+            std::cout << prefix << " ";
+            printName(eventCode);
+            std::cout << " " << entry->second << " " << entry->first << std::endl;
+        }
+    }
+
+    /* Print per-thread results and their distribution */
+    void printThreads(const std::vector<int> &events)
+    {
+        for (auto eventCode : events)
+        {
+            auto threadResults = GetThreadResults(eventCode);
+            auto stats = computeStatistics(threadResults);
+
+            std::cout << getDescription(eventCode) << ":" << std::endl;
+            int count = threadResults.size();
+            for (int i = 0; i < count; i++)
+                std::cout << "  Thread " << i << ": " << threadResults[i] << std::endl;
+            std::cout << "  min: " << stats.min << ", max: " << stats.max << ", mean: " << stats.mean
+                      << ", stddev: " << stats.stddev << ", imbalance: " << stats.imbalance << std::endl;
+        }
+
+        /* Print one line per event with the name followed by the per-thread values */
+        for (auto eventCode : events)
+        {
+            std::cout << "@%T ";
+            printName(eventCode);
+            for (auto value : GetThreadResults(eventCode))
+                std::cout << " " << value;
+            std::cout << std::endl;
+        }
+    }
+
+    /* Print the values of every region */
+    void printRegions(const std::vector<int> &events, const PapiWrapperRegions &regions)
+    {
+        int count = events.size();
+        for (int region = 0; region < regions.Size(); region++)
+        {
+            std::cout << regions.Name(region) << " (" << regions.Intervals(region) << " intervals):" << std::endl;
+            for (int i = 0; i < count; i++)
+                std::cout << "  " << getDescription(events[i]) << ": " << regions.Values(region)[i] << std::endl;
+        }
+
+        /* Print Headers */
+        std::cout << "@%% REGION INTERVALS ";
+        for (auto eventCode : events)
+        {
+            printName(eventCode);
+            std::cout << " ";
+        }
+        std::cout << std::endl;
+
+        /* Print one line per region */
+        for (int region = 0; region < regions.Size(); region++)
+        {
+            std::cout << "@%R " << regions.Name(region) << " " << regions.Intervals(region) << " ";
+            for (int i = 0; i < count; i++)
+                std::cout << regions.Values(region)[i] << " ";
+            std::cout << std::endl;
+        }
+        printRegionEnergy();
+    }
+
+    /* Print the call tree of nested regions */
+    void printCallTree(const std::vector<int> &events, const PapiWrapperCallTree &tree)
+    {
+        for (auto node = tree.Root()->child; node != nullptr; node = node->sibling)
+            printCallTreeNode(events, tree, node, 0);
+
+        /* Print Headers */
+        std::cout << "@%% PATH INTERVALS ";
+        for (auto eventCode : events)
+        {
+            printName(eventCode);
+            std::cout << " ";
+        }
+        std::cout << std::endl;
+
+        /* Print one line with inclusive and one with exclusive values per node */
+        std::string path;
+        for (auto node = tree.Root()->child; node != nullptr; node = node->sibling)
+            printCallTreeLines(events, tree, node, path);
+    }
+
+    /* Print a node of the call tree and its children */
+    void printCallTreeNode(const std::vector<int> &events, const PapiWrapperCallTree &tree, const PapiWrapperCallTree::Node *node, const int level)
+    {
+        std::string indent(2 * level, ' ');
+        std::cout << indent << node->name << " (" << node->intervals << " intervals):" << std::endl;
+        int count = events.size();
+        for (int i = 0; i < count; i++)
+            std::cout << indent << "  " << getDescription(events[i]) << ": inclusive " << node->values[i]
+                      << ", exclusive " << tree.Exclusive(node, i) << std::endl;
+
+        for (auto child = node->child; child != nullptr; child = child->sibling)
+            printCallTreeNode(events, tree, child, level + 1);
+    }
+
+    /* Print the machine readable lines of a node of the call tree and its children */
+    void printCallTreeLines(const std::vector<int> &events, const PapiWrapperCallTree &tree, const PapiWrapperCallTree::Node *node, std::string &path)
+    {
+        auto length = path.size();
+        path += (length == 0 ? "" : "/");
+        path += node->name;
+
+        int count = events.size();
+        std::cout << "@%I " << path << " " << node->intervals << " ";
+        for (int i = 0; i < count; i++)
+            std::cout << node->values[i] << " ";
+        std::cout << std::endl;
+        std::cout << "@%E " << path << " " << node->intervals << " ";
+        for (int i = 0; i < count; i++)
+            std::cout << tree.Exclusive(node, i) << " ";
+        std::cout << std::endl;
+
+        for (auto child = node->child; child != nullptr; child = child->sibling)
+            printCallTreeLines(events, tree, child, path);
+        path.resize(length);
+    }
+
+    /* Get the value of an event inside a region or exit with an error if the region is unknown */
+    long long getRegionResult(const std::vector<int> &events, const PapiWrapperRegions &regions, const PAPIW::RegionName &name, const int eventCode)
+    {
+        int region = regions.Lookup(name);
+        if (region == -1)
+            handle_error("GetRegionResult", "The region has never been measured");
+
+        auto indexInResult = std::find(events.begin(), events.end(), eventCode);
+        if (indexInResult == events.end())
+            handle_error("GetRegionResult", "The event is not supported or has not been added to the set");
+
+        return regions.Values(region)[indexInResult - events.begin()];
+    }
+
+    /* Print the event name without its description */
+    void printName(const int eventCode)
+    {
+        std::cout << getName(eventCode);
+    }
+
+    /* Compute the distribution of per-thread values */
+    static PapiWrapperStatistics computeStatistics(const std::vector<long long> &threadResults)
+    {
+        PapiWrapperStatistics stats;
+        if (threadResults.empty())
+            return stats;
+
+        auto minmax = std::minmax_element(threadResults.begin(), threadResults.end());
+        stats.min = *minmax.first;
+        stats.max = *minmax.second;
+
+        double sum = 0;
+        for (auto value : threadResults)
+            sum += value;
+        stats.mean = sum / threadResults.size();
+
+        double squares = 0;
+        for (auto value : threadResults)
+            squares += (value - stats.mean) * (value - stats.mean);
+        stats.stddev = sqrt(squares / threadResults.size());
+
+        stats.imbalance = stats.mean != 0 ? stats.max / stats.mean : 0;
+        return stats;
+    }
+
+    /* Get the name of an event. Events which are not in the table are printed as their code */
+    std::string getName(const int eventCode)
+    {
+        auto entry = eventTable.Find(eventCode);
+        if (entry != nullptr)
+            return entry->symbol;
+
+        char name[16];
+        snprintf(name, sizeof(name), "0x%x", eventCode);
+        return name;
+    }
+
+    /* True if the backend reads the counters of the cpu component in user space, e.g. Papi with rdpmc */
+    static bool fastReadSupported()
+    {
+        return PapiWrapperBackend::Get().FastCounterRead();
+    }
+
+    /* Check that the backend knows an event, s.t. the event sets of the threads do not skip it. Warns otherwise */
+    bool queryEvent(const int eventCode)
+    {
+        retval = PapiWrapperBackend::Get().QueryEvent(eventCode);
+        if (retval == PAPI_OK)
+            return true;
+
+        char name[PAPI_MAX_STR_LEN];
+        if (PapiWrapperBackend::Get().EventCodeToName(eventCode, name) != PAPI_OK)
+            snprintf(name, sizeof(name), "0x%x", eventCode);
+        issue_waring("AddEvent. Could not add", name, retval);
+        return false;
+    }
+
+    /* Get Descriptiion Text of event */
+    const char *getDescription(const int eventCode)
+    {
+        auto entry = eventTable.Find(eventCode);
+        return entry != nullptr ? entry->label.c_str() : PAPIW::GetPresetDescription(eventCode);
+    }
+};
+
+/**
+ * PapiWrapper class for Sequential use
+ * 
+ * It is discoureaged to use this class directly but rather through the utility functions
+ * inside the PAPIW namespace.
+ */
+class PapiWrapperSingle : public PapiWrapper
+{
+private:
+    int eventSet = PAPI_NULL;
+    bool running = false;
+    bool fastRead = false; // If true, the counters stay enabled and Start and Stop only read them
+    bool counting = false; // True while the Papi counters are enabled
+    std::vector<long long> buffer;
+    std::vector<long long> origin; // Counter values at Start in the fast read mode
+    std::vector<long long> values;
+    std::vector<long long> overhead; // Calibrated counts of an empty Start/Stop pair per event
+    std::vector<long long> corrected; // Values corrected by the overhead, reused by every Print
+    long long intervals = 0;         // Number of Start/Stop pairs
+    std::vector<int> events;
+    long long startTime = 0;
+    long long enabledTime = 0; // Nanoseconds the counters were running
+    long long virtStartTime = 0;
+    long long virtTime = 0; // Cpu nanoseconds of the thread while the counters were running
+    int startCpu = -1;      // Cpu of the thread at the last Start
+    int stopCpu = -1;       // Cpu of the thread at the last Stop
+    PapiWrapperSamples *samples = nullptr;
+    bool ownsSamples = false;
+
+    /* Samples of the thread whose counters are running, s.t. the overflow handler finds them */
+    inline static thread_local PapiWrapperSamples *activeSamples = nullptr;
+    PapiWrapperRegions *regions = nullptr; // Created on first use, s.t. all events are known
+
+public:
+    /**
+     * @param multiplexed If true, the events share the hardware counters. This allows to count more events
+     *                    than there are counters, but the values are only estimates
+     */
+    PapiWrapperSingle(const bool multiplexed = false) : PapiWrapper(multiplexed), ThreadID(0)
+    {
+        mode = "single";
+    }
+    PapiWrapperSingle(const unsigned long threadID, const bool multiplexed = false) : PapiWrapper(multiplexed), ThreadID(threadID)
+    {
+        mode = "single";
+    }
+    ~PapiWrapperSingle()
+    {
+        delete regions;
+        if (activeSamples == samples)
+            activeSamples = nullptr;
+        if (ownsSamples)
+            delete samples;
+
+        /* Release the event set, s.t. Papi does not run out of them when instances are rebuilt often */
+        if (eventSet == PAPI_NULL)
+            return;
+        if (running)
+            PapiWrapperTimeSeries::Detach();
+        if (counting)
+            PapiWrapperBackend::Get().Stop(eventSet, buffer.data());
+        retval = PapiWrapperBackend::Get().CleanupEventSet(eventSet);
+        if (retval == PAPI_OK)
+            retval = PapiWrapperBackend::Get().DestroyEventSet(&eventSet);
+        if (retval != PAPI_OK)
+            issue_waring("~PapiWrapperSingle", "Could not destroy the event set. It has to be destroyed by the thread which created it", retval);
+    }
+
+    const unsigned long ThreadID;
+
+    /* Forget the event set without releasing it, e.g. because its thread is gone. The instance may only be deleted afterwards */
+    void Abandon()
+    {
+        if (activeSamples == samples)
+            activeSamples = nullptr;
+        eventSet = PAPI_NULL;
+        running = false;
+        counting = false;
+    }
+
+    /* Add an event to be counted */
+    void AddEvent(const int eventCode) override
+    {
+        if (running)
+            handle_error("AddEvent", "You can't add events while Papi is running\n");
+        disableCounters();
+        overhead.clear();
+
+        if (eventSet == PAPI_NULL)
+        {
+            retval = PapiWrapperBackend::Get().CreateEventSet(&eventSet);
+            if (retval != PAPI_OK)
+                handle_error("AddEvent", "Could not create event set", retval);
+
+            /* A multiplexed event set has to be bound to a component before it can be converted */
+            if (multiplexed)
+            {
+                retval = PapiWrapperBackend::Get().AssignEventSetComponent(eventSet, 0);
+                if (retval != PAPI_OK)
+                    handle_error("AddEvent", "Could not assign event set to the cpu component", retval);
+
+                retval = PapiWrapperBackend::Get().SetMultiplex(eventSet);
+                if (retval != PAPI_OK)
+                    handle_error("AddEvent", "Could not enable multiplexing", retval);
+            }
+        }
+
+        retval = PapiWrapperBackend::Get().AddEvent(eventSet, eventCode);
+        if (retval != PAPI_OK)
+        {
+            char name[PAPI_MAX_STR_LEN];
+            if (PapiWrapperBackend::Get().EventCodeToName(eventCode, name) != PAPI_OK)
+                snprintf(name, sizeof(name), "0x%x", eventCode);
+            issue_waring("AddEvent. Could not add", name, retval);
+        }
+        else
+        {
+            events.push_back(eventCode);
+            buffer.push_back(0);
+            origin.push_back(0);
+            values.push_back(0);
+            corrected.push_back(0);
+        }
+    }
+
+    /* Start the counter */
+    void Start() override
+    {
+        PapiWrapperEnergy::Begin(PapiWrapperEnergy::IntervalRegion);
+        startCpu = PapiWrapperTopology::CurrentCpu();
+        StartCounters();
+    }
+
+    /* Stop the counter */
+    void Stop() override
+    {
+        if (!running)
+            handle_error("Stop", "You can not stop an already stopped Papi instance");
+        if (regions != nullptr && regions->Depth() != 0 && regions->IsOwner())
+            handle_error("Stop", "The counters were started by a region. End the region instead");
+
+        StopCounters();
+        stopCpu = PapiWrapperTopology::CurrentCpu();
+        PapiWrapperEnergy::End(PapiWrapperEnergy::IntervalRegion);
+
+        int count = events.size();
+        for (int i = 0; i < count; i++)
+            values[i] += buffer[i];
+        enabledTime += PapiWrapperBackend::Get().GetRealNsec() - startTime;
+        virtTime += PapiWrapperBackend::Get().GetVirtNsec() - virtStartTime;
+        intervals++;
+        PapiWrapperDistribution::Record(PapiWrapperDistribution::IntervalRegion, nullptr, buffer.data(), events.size());
+        PapiWrapperTrace::Append(PAPIW::Trace::IntervalRegion, nullptr, buffer.data(), events.size(), nullptr,
+                                 stopCpu != startCpu ? PAPIW::Trace::RecordMigrated : 0);
+    }
+
+    /**
+     * Start the counters without beginning an interval, e.g. for a region. Stop them with StopCounters,
+     * which leaves the values in the buffer instead of adding them to the results
+     */
+    void StartCounters()
+    {
+        if (running)
+            handle_error("Start", "You can not start an already running PAPI instance");
+
+        if (!counting)
+        {
+            retval = PapiWrapperBackend::Get().Start(eventSet);
+            if (retval != PAPI_OK)
+                handle_error("Start", "Could not start PAPI counters", retval);
+            counting = true;
+        }
+
+        /* The counters keep running, so the values at this point are subtracted from every read */
+        if (fastRead)
+        {
+            retval = PapiWrapperBackend::Get().Read(eventSet, origin.data());
+            if (retval != PAPI_OK)
+                handle_error("Start", "Could not read PAPI counters", retval);
+        }
+
+        if (samples != nullptr)
+            activeSamples = samples;
+        PapiWrapperTimeSeries::Attach(eventSet, fastRead ? origin.data() : nullptr);
+
+        startTime = PapiWrapperBackend::Get().GetRealNsec();
+        virtStartTime = PapiWrapperBackend::Get().GetVirtNsec();
+        running = true;
+    }
+
+    /* Stop the counters started by StartCounters and leave the values of the interval in the buffer */
+    void StopCounters()
+    {
+        if (!running)
+            handle_error("Stop", "You can not stop an already stopped Papi instance");
+
+        PapiWrapperTimeSeries::Detach();
+        if (fastRead)
+            Read(buffer.data());
+        else
+        {
+            retval = PapiWrapperBackend::Get().Stop(eventSet, buffer.data());
+            if (retval != PAPI_OK)
+                handle_error("Stop", "Could not stop PAPI counters", retval);
+            counting = false;
+        }
+
+        if (samples != nullptr)
+        {
+            activeSamples = nullptr;
+            samples->Drain(eventSet, events);
+        }
+
+        running = false;
+    }
+
+    /* Measure empty Start/Stop pairs. The values counted so far are reset */
+    void Calibrate(const int repetitions) override
+    {
+        if (running)
+            handle_error("Calibrate", "You can't calibrate while Papi is running");
+        if (repetitions <= 0)
+            handle_error("Calibrate", "The number of repetitions has to be positive");
+
+        int count = events.size();
+        std::vector<long long> counts(count * repetitions);
+        for (int repetition = 0; repetition < repetitions; repetition++)
+        {
+            StartCounters();
+            StopCounters();
+            for (int i = 0; i < count; i++)
+                counts[i * repetitions + repetition] = buffer[i];
+        }
+
+        overhead.resize(count);
+        for (int i = 0; i < count; i++)
+        {
+            std::vector<long long> eventCounts(counts.begin() + i * repetitions, counts.begin() + (i + 1) * repetitions);
+            overhead[i] = median(eventCounts);
+        }
+        Reset();
+        correctOverhead = true;
+    }
+
+    /* Get the calibrated overhead of one Start/Stop pair */
+    long long GetOverhead(const int eventCode) override
+    {
+        int index = getIndex(eventCode);
+        return overhead.empty() ? 0 : overhead[index];
+    }
+
+    /* Get the result of a specific event without the overhead correction */
+    long long GetRawResult(const int eventCode) override
+    {
+        if (running)
+            handle_error("GetRawResult", "You can't get results while Papi is running\n");
+
+        return values[getIndex(eventCode)];
+    }
+
+    /* Read the current values of the running counters without stopping them */
+    void Read(long long *current)
+    {
+        PapiWrapperTimeSeries::SetBusy(true);
+        retval = PapiWrapperBackend::Get().Read(eventSet, current);
+        PapiWrapperTimeSeries::SetBusy(false);
+        if (retval != PAPI_OK)
+            handle_error("Read", "Could not read PAPI counters", retval);
+
+        if (fastRead)
+        {
+            int count = events.size();
+            for (int i = 0; i < count; i++)
+                current[i] -= origin[i];
+        }
+    }
+
+    /* Keep the counters enabled and only read them on Start and Stop */
+    bool EnableFastRead() override
+    {
+        if (running)
+            handle_error("EnableFastRead", "You can't change the read mode while Papi is running");
+        if (multiplexed || samples != nullptr)
+            handle_error("EnableFastRead", "The fast read mode can not be combined with multiplexing or sampling");
+
+        fastRead = fastReadSupported();
+        if (!fastRead)
+            issue_waring("EnableFastRead", "rdpmc is not available, the counters are started and stopped as before");
+        return fastRead;
+    }
+
+    /* Start measuring a named region. The counters are started if they are not running yet */
+    void BeginRegion(const PAPIW::RegionName &name) override
+    {
+        if (regions == nullptr)
+            regions = new PapiWrapperRegions(events.size());
+
+        bool owner = !running;
+        if (owner)
+            StartCounters();
+
+        long long *snapshot = regions->Enter(name, owner);
+        if (snapshot == nullptr)
+            handle_error("BeginRegion", "Too many regions. Check PAPIW_MAX_REGIONS and PAPIW_MAX_REGION_DEPTH");
+        PapiWrapperEnergy::Begin(name.hash, name.name);
+        Read(snapshot);
+    }
+
+    /* Stop measuring the innermost named region. The counters are stopped if they were started by it */
+    void EndRegion(const PAPIW::RegionName &name) override
+    {
+        if (regions == nullptr || regions->Depth() == 0)
+            handle_error("EndRegion", "There is no region to end");
+
+        bool owner = regions->IsOwner();
+        PapiWrapperEnergy::End(name.hash);
+        if (owner)
+            StopCounters();
+        else
+            Read(buffer.data());
+
+        PapiWrapperTrace::Append(name.hash, name.name, buffer.data(), events.size(), regions->Snapshot());
+        PapiWrapperDistribution::Record(name.hash, name.name, buffer.data(), events.size(), regions->Snapshot());
+        if (!regions->Leave(name, buffer.data()))
+            handle_error("EndRegion", "Regions have to be ended in the reverse order they were begun");
+    }
+
+    /* Record the instruction pointer whenever an event occurred threshold times */
+    void EnableSampling(const int eventCode, const int threshold) override
+    {
+        if (samples == nullptr)
+        {
+            samples = new PapiWrapperSamples();
+            ownsSamples = true;
+        }
+        SampleInto(eventCode, threshold, samples);
+    }
+
+    /* Same as EnableSampling, but record into samples owned by the caller */
+    void SampleInto(const int eventCode, const int threshold, PapiWrapperSamples *target)
+    {
+        if (running)
+            handle_error("EnableSampling", "You can't enable sampling while Papi is running");
+        if (multiplexed)
+            handle_error("EnableSampling", "Sampling is not supported for multiplexed events");
+        if (fastRead)
+            handle_error("EnableSampling", "Sampling is not supported in the fast read mode");
+        if (std::find(events.begin(), events.end(), eventCode) == events.end())
+            handle_error("EnableSampling", "The event is not supported or has not been added to the set");
+
+        if (samples != target && ownsSamples)
+            delete samples;
+        ownsSamples = ownsSamples && samples == target;
+        samples = target;
+
+        retval = PapiWrapperBackend::Get().Overflow(eventSet, eventCode, threshold, overflowHandler);
+        if (retval == PAPI_ENOSUPP)
+            issue_waring("EnableSampling", "The backend does not support sampling, no samples are recorded", retval);
+        else if (retval != PAPI_OK)
+            handle_error("EnableSampling", "Could not enable overflow sampling", retval);
+    }
+
+    /* Print the functions and addresses with the most samples */
+    void PrintSamples() override
+    {
+        if (running)
+            handle_error("PrintSamples", "You can not print while Papi is running. Stop the counters first!");
+
+        std::cout << "PAPIW Single PapiWrapper sample report:" << std::endl;
+        if (samples != nullptr)
+            printSamples(*samples);
+    }
+
+    /* Get the result of a specific event inside a named region */
+    long long GetRegionResult(const PAPIW::RegionName &name, const int eventCode) override
+    {
+        if (regions == nullptr)
+            handle_error("GetRegionResult", "No region has been measured");
+
+        return getRegionResult(events, *regions, name, eventCode);
+    }
+
+    /* Getter Method for the region values */
+    const PapiWrapperRegions *GetRegions()
+    {
+        return regions;
+    }
+
+    /* Get the result of a specific event */
+    long long GetResult(const int eventCode) override
+    {
+        if (running)
+            handle_error("GetResult", "You can't get results while Papi is running\n");
+
+        return result(getIndex(eventCode));
+    }
+
+    /* Copy the results of all events in the order of GetEvents() into results */
+    void GetResults(long long *results) override
+    {
+        if (running)
+            handle_error("GetResults", "You can't get results while Papi is running\n");
+
+        int count = events.size();
+        for (int i = 0; i < count; i++)
+            results[i] = result(i);
+    }
+
+    /* Reset the intermediate counter values */
+    void Reset()
+    {
+        if (running)
+            handle_error("Reset", "You can't reset while Papi is running\n");
+
+        localInit();
+        if (regions != nullptr)
+            regions->Reset();
+        if (samples != nullptr && ownsSamples)
+            samples->Reset();
+    }
+
+    /* Getter Method for running state */
+    bool IsRunning()
+    {
+        return running;
+    }
+
+    /* Print the results */
+    const long long *GetValues()
+    {
+        return values.data();
+    }
+
+    /* Get the nanoseconds the counters were running. For multiplexed events, the values are scaled to this time */
+    long long GetEnabledTime() override
+    {
+        return enabledTime;
+    }
+
+    /* Same as the enabled time for a single thread */
+    long long GetRealTime() override
+    {
+        return enabledTime;
+    }
+
+    /* Get the cpu nanoseconds of the thread while the counters were running */
+    long long GetVirtTime() override
+    {
+        return virtTime;
+    }
+
+    /* Get the cpu the calling thread was on at the last Start, -1 before the first */
+    int GetStartCpu()
+    {
+        return startCpu;
+    }
+
+    /* Get the cpu the calling thread was on at the last Stop, -1 before the first */
+    int GetStopCpu()
+    {
+        return stopCpu;
+    }
+
+    /* Get the codes of the counted events */
+    const std::vector<int> &GetEvents() override
+    {
+        return events;
+    }
+
+    /* Print the results */
+    void Print() override
+    {
+        if (running)
+            handle_error("Print", "You can not print while Papi is running. Stop the counters first!");
+
+        if (printText)
+        {
+            GetResults(corrected.data());
+            std::cout << "PAPIW Single PapiWrapper instance report:" << std::endl;
+            print(events, corrected.data());
+            printOverhead(events);
+            printMetrics(corrected.data());
+            if (multiplexed)
+                printMultiplexed(events, enabledTime);
+        }
+        exportOnPrint();
+    }
+
+    /* There is only one thread, so this is the same as GetResult */
+    std::vector<long long> GetThreadResults(const int eventCode) override
+    {
+        return {GetResult(eventCode)};
+    }
+
+    /* Print the results of the single thread */
+    void PrintThreads() override
+    {
+        if (running)
+            handle_error("PrintThreads", "You can not print while Papi is running. Stop the counters first!");
+
+        std::cout << "PAPIW Single PapiWrapper thread report:" << std::endl;
+        printThreads(events);
+    }
+
+    /* Print the results of all named regions */
+    void PrintRegions() override
+    {
+        std::cout << "PAPIW Single PapiWrapper region report:" << std::endl;
+        if (regions != nullptr)
+            printRegions(events, *regions);
+    }
+
+    /* Print the call tree of nested regions */
+    void PrintCallTree() override
+    {
+        std::cout << "PAPIW Single PapiWrapper call tree report:" << std::endl;
+        if (regions != nullptr)
+            printCallTree(events, regions->CallTree());
+    }
+
+private:
+    /* Stop the counters which are kept enabled in the fast read mode */
+    void disableCounters()
+    {
+        if (!counting)
+            return;
+
+        retval = PapiWrapperBackend::Get().Stop(eventSet, buffer.data());
+        if (retval != PAPI_OK)
+            handle_error("Stop", "Could not stop PAPI counters", retval);
+        counting = false;
+    }
+
+    /* Called by Papi in a signal handler of the thread whose counter overflowed */
+    static void overflowHandler(int eventSet, void *address, long long overflowVector, void *context)
+    {
+        (void)eventSet;
+        (void)context;
+        if (activeSamples != nullptr)
+            activeSamples->Push(address, overflowVector);
+    }
+
+protected:
+    /* Initialize the values array */
+    void localInit() override
+    {
+        std::fill(values.begin(), values.end(), 0);
+        enabledTime = 0;
+        virtTime = 0;
+        intervals = 0;
+    }
+
+    /* Get the position of an event or exit with an error if it is not counted */
+    int getIndex(const int eventCode)
+    {
+        auto indexInResult = std::find(events.begin(), events.end(), eventCode);
+        if (indexInResult == events.end())
+            handle_error("GetResult", "The event is not supported or has not been added to the set");
+        return indexInResult - events.begin();
+    }
+
+    /* Value of an event, corrected by the calibrated overhead if enabled */
+    long long result(const int index)
+    {
+        if (!correctOverhead || overhead.empty())
+            return values[index];
+        return std::max(0LL, values[index] - overhead[index] * intervals);
+    }
+
+    const PapiWrapperRegions *getRegions() override
+    {
+        return regions;
+    }
+
+    void appendThreadResults(const int eventCode, std::vector<long long> &results) override
+    {
+        results.push_back(GetResult(eventCode));
+    }
+};
+
+#ifdef _OPENMP
+/**
+ * PapiWrapper class for Parallel use
+ *
+ * Every thread counts into its own slot. The threads of the outermost team use the slot of their thread number.
+ * Threads of nested teams get a slot for their thread numbers on all levels. The master of a nested team is the
+ * same thread as in the enclosing team, so it keeps the slot of the enclosing team and is counted only once.
+ * In elastic mode, slots belong to OS threads instead, s.t. the team size may change while the counters are running.
+ *
+ * It is discoureaged to use this class directly but rather through the utility functions
+ * inside the PAPIW namespace.
+ */
+class PapiWrapperParallel : public PapiWrapper
+{
+private:
+    static int const valuesPerLine = PAPIW_CACHE_LINE_SIZE / sizeof(long long);
+
+    /* Values of one thread are padded to full cache lines, s.t. threads never write to the same line */
+    struct alignas(PAPIW_CACHE_LINE_SIZE) CacheLine
+    {
+        long long values[valuesPerLine];
+    };
+
+    /* Values and per-thread objects of one thread. Slots are allocated one by one and never move */
+    struct Slot
+    {
+        std::vector<CacheLine> lines;           // Events, enabled time, virtual time and number of intervals
+        PapiWrapperSingle *papi = nullptr;      // Event set kept between Stop and Start (persistent mode only)
+        PapiWrapperSingle *running = nullptr;   // Event set started by Start, s.t. it can be harvested if its thread left
+        std::atomic<bool> departed{false};      // True if the thread left the elastic team while counting, until it folds its values in
+        PapiWrapperRegions *regions = nullptr;  // Named regions of the thread, created on first use
+        PapiWrapperSamples *samples = nullptr;  // Instruction pointer samples of the thread
+        std::vector<long long> overhead;        // Calibrated overhead of every event
+        int level = 1;                          // Nesting level of the team the thread counts in
+        int startCpu = -1;                      // Cpu the thread started its last interval on
+        int stopCpu = -1;                       // Cpu the thread stopped its last interval on
+        long long migrations = 0;               // Intervals in which the thread changed its cpu
+        std::map<int, std::vector<long long>> cpuValues; // Events and number of intervals by the cpu they were started on
+
+        /* The event set is not deleted here, since it has to be released by its own thread */
+        ~Slot()
+        {
+            delete regions;
+            delete samples;
+        }
+
+        long long &Value(const int index)
+        {
+            return lines[index / valuesPerLine].values[index % valuesPerLine];
+        }
+    };
+
+    /* Lets threads reach the instance when they exit, as long as it is alive */
+    struct Lifetime
+    {
+        std::mutex mutex;
+        PapiWrapperParallel *instance = nullptr;
+    };
+
+    /* Runs when a thread exits, e.g. when the runtime shrinks its pool, s.t. the thread releases its own event sets */
+    struct ExitHandler
+    {
+        std::shared_ptr<Lifetime> lifetime; // Instance the thread last created a persistent event set for
+
+        ~ExitHandler()
+        {
+            if (lifetime == nullptr)
+                return;
+            std::lock_guard<std::mutex> lock(lifetime->mutex);
+            if (lifetime->instance != nullptr)
+                lifetime->instance->threadExit();
+        }
+    };
+
+    inline static PapiWrapperSingle *localPapi;
+    inline static Slot *localSlot;
+    inline static int localLevel; // Nesting level at which the counters of the thread were started
+#pragma omp threadprivate(localPapi, localSlot, localLevel)
+    inline static thread_local ExitHandler exitHandler;
+    std::shared_ptr<Lifetime> lifetime = std::make_shared<Lifetime>();
+    std::vector<int> events;
+    std::vector<Slot *> slots;             // Fixed size, s.t. nested teams can add slots while other threads count
+    int numSlots = 0;                      // Number of slots in use
+    int outerSlots = 0;                    // Slots reserved for the outermost team, indexed by thread number
+    std::map<std::vector<int>, int> nestedSlots;     // Slot of every other thread by its thread numbers on all levels
+    std::map<unsigned long, int> threadSlots;        // Slot of every OS thread (elastic mode only)
+    PapiWrapperRegions *mergedRegions = nullptr;     // Sum of the regions of all slots, reused by every export
+    std::vector<std::pair<int, int>> sampledEvents;  // Event code and threshold of every sampled event
+    std::atomic<int> numRunningThreads{0}; //0 is none running
+    int startedThreads = 0;                // Size of the outermost team which started the counters
+    bool fastRead = false;                 // If true, the event sets of the threads are only read on Start and Stop
+    bool startedFromParallelRegion = false;
+    std::atomic<bool> elasticRunning{false}; // True from Start to Stop of the whole team in elastic mode
+    PapiWrapperTopology *topology = nullptr; // Sockets, cores and nodes of the cpus, read on first use
+    std::vector<PapiWrapperSingle *> retired; // Event sets of threads which lost their slot, released by their own thread
+    std::atomic<int> numRetired{0};
+    std::atomic<int> harvestedThreads{0};    // Threads which left the elastic team while counting and folded their values in since
+    std::atomic<int> pendingThreads{0};      // Threads which left the elastic team while counting and did not fold their values in yet
+    const bool persistent;
+    const bool elastic;
+
+public:
+    /**
+     * @param persistent If true, every thread keeps its event set alive between Stop and Start
+     *                   and only rebuilds it when the thread behind its team slot changes
+     * @param multiplexed If true, the events share the hardware counters and the values are scaled estimates
+     * @param elastic If true, the team size may change while the counters are running. Threads are registered
+     *                on their first Start or BeginRegion. The counters of threads which left are harvested by Stop
+     *                and folded in by these threads on their next Start, Stop or BeginRegion or when they exit
+     */
+    PapiWrapperParallel(const bool persistent = false, const bool multiplexed = false, const bool elastic = false)
+        : PapiWrapper(multiplexed), persistent(persistent || elastic), elastic(elastic)
+    {
+        mode = elastic ? "elastic" : "parallel";
+        lifetime->instance = this;
+    }
+    ~PapiWrapperParallel()
+    {
+        std::cout << "Destructing Local Papis" << std::endl;
+        checkNotInParallelRegion("DESTRUCTOR");
+        {
+            std::lock_guard<std::mutex> lock(lifetime->mutex);
+            lifetime->instance = nullptr;
+        }
+#pragma omp parallel
+        {
+            if (persistent)
+                releaseOwned();
+            else
+                delete localPapi;
+            localPapi = nullptr;
+            localSlot = nullptr;
+        }
+
+        /* Event sets of threads which are not part of the team can not be released by them any more */
+        int abandoned = 0;
+        for (int slot = 0; slot < numSlots; slot++)
+        {
+            if (slots[slot]->papi != nullptr)
+                retired.push_back(slots[slot]->papi);
+            delete slots[slot];
+        }
+        for (auto papi : retired)
+        {
+            papi->Abandon();
+            delete papi;
+            abandoned++;
+        }
+        if (abandoned != 0)
+            issue_waring("~PapiWrapperParallel", (std::to_string(abandoned) + " event sets of threads outside of the team are left to Papi").c_str());
+        delete mergedRegions;
+        delete topology;
+    }
+
+    /* Getter Method for the persistent mode */
+    bool IsPersistent()
+    {
+        return persistent;
+    }
+
+    /* Register events to be counted */
+    void AddEvent(const int eventCode) override
+    {
+        checkNotInParallelRegion("ADD_EVENT");
+        checkNoneRunning("ADD_EVENT");
+        if (!queryEvent(eventCode))
+            return;
+        events.push_back(eventCode);
+        for (int slot = 0; slot < numSlots; slot++)
+        {
+            slots[slot]->overhead.clear();
+            slots[slot]->cpuValues.clear(); // Laid out for the previous events
+            layoutSlot(slots[slot]);
+        }
+    }
+
+    /**
+     * Start the counters. Outside of a parallel region, they are started on every thread of the team.
+     * Inside, they are started on every thread of the current team which is not counting for an enclosing team yet.
+     * In elastic mode, Start inside a parallel region only registers the calling thread and may be called by any thread
+     */
+    void Start() override
+    {
+        if (isInParallelRegion())
+        {
+            if (omp_get_level() == 1 && !elastic)
+            {
+#pragma omp single
+                {
+                    checkNoneRunning("START");
+                    startedThreads = omp_get_num_threads();
+                }
+            }
+            if (omp_get_level() == 1)
+                startedFromParallelRegion = true;
+            if (elastic)
+                elasticRunning = true;
+            start();
+        }
+        else
+        {
+            checkNoneRunning("START");
+            startedFromParallelRegion = false;
+            startedThreads = GetNumThreads();
+            elasticRunning = elastic;
+#pragma omp parallel
+            {
+                start();
+            }
+        }
+    }
+
+    /**
+     * Stop the counters, which were started on the same nesting level.
+     * In elastic mode, the counters of threads which are not part of the current team any more are harvested
+     */
+    void Stop() override
+    {
+        if (omp_get_level() <= 1 && !elastic)
+            checkNumberOfThreads("STOP");
+
+        if (isInParallelRegion())
+        {
+            if (omp_get_level() == 1 && !startedFromParallelRegion && !elastic)
+                issue_waring("Stop", "The Papi Counters have not been started in a parallel Region. You should not stop them in a parallel region, however, the results should be fine.");
+            stop();
+
+#pragma omp barrier
+            if (elastic && omp_get_level() == 1)
+            {
+#pragma omp single
+                harvest();
+            }
+        }
+        else
+        {
+            if (startedFromParallelRegion && !elastic)
+                issue_waring("Stop", "The Papi Counters have been started in a parallel Region. You should stop them in the same parallel region or move Start/Stop completely out of the parallel region.");
+#pragma omp parallel
+            {
+                stop();
+            }
+            if (elastic)
+                harvest();
+        }
+    }
+
+    /* Get the result of a specific event */
+    long long GetResult(const int eventCode) override
+    {
+        checkNoneRunning("GET_RESULT");
+
+        int index = getIndex(eventCode);
+        long long total = 0;
+        for (int slot = 0; slot < numSlots; slot++)
+            total += slotResult(slots[slot], index);
+        return total;
+    }
+
+    /* Copy the results of all events in the order of GetEvents() into results, summed up over all threads */
+    void GetResults(long long *results) override
+    {
+        checkNoneRunning("GET_RESULTS");
+
+        for (size_t index = 0; index < events.size(); index++)
+        {
+            results[index] = 0;
+            for (int slot = 0; slot < numSlots; slot++)
+                results[index] += slotResult(slots[slot], index);
+        }
+    }
+
+    /* Get the result of a specific event without the overhead correction */
+    long long GetRawResult(const int eventCode) override
+    {
+        checkNoneRunning("GET_RAW_RESULT");
+
+        int index = getIndex(eventCode);
+        long long total = 0;
+        for (int slot = 0; slot < numSlots; slot++)
+            total += slots[slot]->Value(index);
+        return total;
+    }
+
+    /* Get the result of a specific event for every nesting level, starting with the outermost team */
+    std::vector<long long> GetLevelResults(const int eventCode) override
+    {
+        checkNoneRunning("GET_LEVEL_RESULTS");
+
+        int index = getIndex(eventCode);
+        std::vector<long long> results(maxLevel(), 0);
+        for (int slot = 0; slot < numSlots; slot++)
+            results[slots[slot]->level - 1] += slotResult(slots[slot], index);
+        return results;
+    }
+
+    /* Get the result of a specific event for every socket, by the cpu the intervals were started on */
+    std::vector<long long> GetSocketResults(const int eventCode) override
+    {
+        checkNoneRunning("GET_SOCKET_RESULTS");
+
+        int index = getIndex(eventCode);
+        std::vector<long long> results;
+        for (auto &socket : aggregate<int>([](const PapiWrapperTopology::Cpu &cpu) { return cpu.socket; }))
+        {
+            results.resize(std::max<size_t>(results.size(), socket.first + 1), 0);
+            results[socket.first] = socket.second[index];
+        }
+        return results;
+    }
+
+    /**
+     * Print where every thread started and stopped its last interval and in how many intervals it migrated,
+     * followed by the results per socket and per core
+     */
+    void PrintPlacement() override
+    {
+        checkNoneRunning("PRINT_PLACEMENT");
+#pragma omp single
+        {
+            auto &cpus = getTopology();
+            std::cout << "PAPIW Parallel PapiWrapper placement report:" << std::endl;
+            for (int slot = 0; slot < numSlots; slot++)
+            {
+                Slot *thread = slots[slot];
+                std::cout << "Thread " << slot << ": started on cpu " << thread->startCpu << " (node " << cpus.Get(thread->startCpu).node
+                          << "), stopped on cpu " << thread->stopCpu << " (node " << cpus.Get(thread->stopCpu).node << "), migrated in "
+                          << thread->migrations << " of " << thread->Value(events.size() + 2) << " intervals" << std::endl;
+            }
+            std::cout << "@%% THREAD START_CPU START_NODE STOP_CPU STOP_NODE INTERVALS MIGRATIONS" << std::endl;
+            for (int slot = 0; slot < numSlots; slot++)
+            {
+                Slot *thread = slots[slot];
+                std::cout << "@%P " << slot << " " << thread->startCpu << " " << cpus.Get(thread->startCpu).node << " " << thread->stopCpu
+                          << " " << cpus.Get(thread->stopCpu).node << " " << thread->Value(events.size() + 2) << " " << thread->migrations << std::endl;
+            }
+
+            auto sockets = aggregate<int>([](const PapiWrapperTopology::Cpu &cpu) { return cpu.socket; });
+            auto cores = aggregate<std::pair<int, int>>([](const PapiWrapperTopology::Cpu &cpu) { return std::make_pair(cpu.socket, cpu.core); });
+            int count = events.size();
+            for (auto &socket : sockets)
+            {
+                std::cout << "Socket " << socket.first << " (" << socket.second[count] << " intervals):" << std::endl;
+                for (int i = 0; i < count; i++)
+                    std::cout << "  " << getDescription(events[i]) << ": " << socket.second[i] << std::endl;
+            }
+
+            std::cout << "@%% SOCKET INTERVALS ";
+            for (auto eventCode : events)
+            {
+                printName(eventCode);
+                std::cout << " ";
+            }
+            std::cout << std::endl;
+            for (auto &socket : sockets)
+            {
+                std::cout << "@%G " << socket.first << " " << socket.second[count] << " ";
+                for (int i = 0; i < count; i++)
+                    std::cout << socket.second[i] << " ";
+                std::cout << std::endl;
+            }
+
+            std::cout << "@%% SOCKET CORE INTERVALS ";
+            for (auto eventCode : events)
+            {
+                printName(eventCode);
+                std::cout << " ";
+            }
+            std::cout << std::endl;
+            for (auto &core : cores)
+            {
+                std::cout << "@%C " << core.first.first << " ";
+                if (core.first.second == PapiWrapperTopology::UnknownCore)
+                    std::cout << "unknown ";
+                else
+                    std::cout << core.first.second << " ";
+                std::cout << core.second[count] << " ";
+                for (int i = 0; i < count; i++)
+                    std::cout << core.second[i] << " ";
+                std::cout << std::endl;
+            }
+        }
+    }
+
+    /**
+     * Measure empty Start/Stop pairs on every thread of the team. The values counted so far are reset.
+     * Threads of nested teams are corrected by the average overhead of the team
+     */
+    void Calibrate(const int repetitions) override
+    {
+        checkNotInParallelRegion("CALIBRATE");
+        checkNoneRunning("CALIBRATE");
+
+        int eventCount = events.size();
+#pragma omp parallel
+        {
+            Slot *slot = slotOf();
+            auto papi = persistent ? acquireSlot(slot) : createLocalPapi(slot);
+            papi->Calibrate(repetitions);
+            papi->CorrectOverhead(false);
+
+            slot->overhead.resize(eventCount);
+            for (int i = 0; i < eventCount; i++)
+                slot->overhead[i] = papi->GetOverhead(events[i]);
+
+            if (!persistent)
+            {
+                delete papi;
+                retval = PapiWrapperBackend::Get().UnregisterThread();
+                if (retval != PAPI_OK)
+                    handle_error("Calibrate", "Couldn't unregister thread", retval);
+            }
+        }
+        Reset();
+        correctOverhead = true;
+    }
+
+    /* Get the calibrated overhead of one Start/Stop pair, averaged over all calibrated threads */
+    long long GetOverhead(const int eventCode) override
+    {
+        int index = getIndex(eventCode);
+        int threads = 0;
+        long long total = 0;
+        for (int slot = 0; slot < numSlots; slot++)
+            if (!slots[slot]->overhead.empty())
+            {
+                total += slots[slot]->overhead[index];
+                threads++;
+            }
+        return threads == 0 ? 0 : total / threads;
+    }
+
+    /* Get the codes of the counted events */
+    const std::vector<int> &GetEvents() override
+    {
+        return events;
+    }
+
+    /* Get the nanoseconds the counters were running, summed up over all threads */
+    long long GetEnabledTime() override
+    {
+        checkNoneRunning("GET_ENABLED_TIME");
+
+        long long total = 0;
+        for (int slot = 0; slot < numSlots; slot++)
+            total += slots[slot]->Value(events.size());
+        return total;
+    }
+
+    /* Get the wall clock nanoseconds the counters were running, i.e. the longest time of all threads */
+    long long GetRealTime() override
+    {
+        checkNoneRunning("GET_REAL_TIME");
+
+        long long longest = 0;
+        for (int slot = 0; slot < numSlots; slot++)
+            longest = std::max(longest, slots[slot]->Value(events.size()));
+        return longest;
+    }
+
+    /* Get the cpu nanoseconds of all threads while the counters were running */
+    long long GetVirtTime() override
+    {
+        checkNoneRunning("GET_VIRT_TIME");
+
+        long long total = 0;
+        for (int slot = 0; slot < numSlots; slot++)
+            total += slots[slot]->Value(events.size() + 1);
+        return total;
+    }
+
+    /* Get the value of a specific event for every thread which was part of a team, the threads of nested teams last */
+    std::vector<long long> GetThreadResults(const int eventCode) override
+    {
+        std::vector<long long> results;
+        appendThreadResults(eventCode, results);
+        return results;
+    }
+
+    /* Print the values */
+    void Print() override
+    {
+        checkNoneRunning("PRINT");
+#pragma omp single
+        {
+            if (printText)
+            {
+                std::vector<long long> totals;
+                for (auto eventCode : events)
+                    totals.push_back(GetResult(eventCode));
+
+                std::cout << "PAPIW Parallel PapiWrapper instance report:" << std::endl;
+                print(events, totals.data());
+                printOverhead(events);
+                printLevels(events);
+                if (elastic)
+                    printContributors();
+                printMetrics(totals.data());
+                if (multiplexed)
+                    printMultiplexed(events, GetEnabledTime());
+            }
+            exportOnPrint();
+        }
+    }
+
+    /* Print the values of every thread */
+    void PrintThreads() override
+    {
+        checkNoneRunning("PRINT_THREADS");
+#pragma omp single
+        {
+            std::cout << "PAPIW Parallel PapiWrapper thread report:" << std::endl;
+            printThreads(events);
+        }
+    }
+
+    /* Reset the values */
+    void Reset()
+    {
+        checkNoneRunning("RESET");
+#pragma omp single
+        {
+            for (int slot = 0; slot < numSlots; slot++)
+            {
+                std::fill(slots[slot]->lines.begin(), slots[slot]->lines.end(), CacheLine{});
+                if (slots[slot]->regions != nullptr)
+                    slots[slot]->regions->Reset();
+                if (slots[slot]->samples != nullptr)
+                    slots[slot]->samples->Reset();
+                slots[slot]->cpuValues.clear();
+                slots[slot]->migrations = 0;
+            }
+            harvestedThreads = 0;
+        }
+    }
+
+    /**
+     * Start measuring a named region. Inside a parallel region, only the calling thread is measured.
+     * Outside, the region is begun on every thread of the team, just like Start
+     */
+    void BeginRegion(const PAPIW::RegionName &name) override
+    {
+        if (isInParallelRegion())
+            beginRegion(name);
+        else
+        {
+#pragma omp parallel
+            beginRegion(name);
+        }
+    }
+
+    /* Stop measuring the innermost named region. Has to be called from the same context as BeginRegion */
+    void EndRegion(const PAPIW::RegionName &name) override
+    {
+        if (isInParallelRegion())
+            endRegion(name);
+        else
+        {
+#pragma omp parallel
+            endRegion(name);
+        }
+    }
+
+    /* Get the result of a specific event inside a named region summed up over all threads */
+    long long GetRegionResult(const PAPIW::RegionName &name, const int eventCode) override
+    {
+        checkNoneRunning("GET_REGION_RESULT");
+        PapiWrapperRegions merged(events.size());
+        mergeRegions(merged);
+        return getRegionResult(events, merged, name, eventCode);
+    }
+
+    /* Print the values of all named regions summed up over all threads */
+    void PrintRegions() override
+    {
+        checkNoneRunning("PRINT_REGIONS");
+#pragma omp single
+        {
+            PapiWrapperRegions merged(events.size());
+            mergeRegions(merged);
+            std::cout << "PAPIW Parallel PapiWrapper region report:" << std::endl;
+            printRegions(events, merged);
+        }
+    }
+
+    /**
+     * Record the instruction pointer whenever an event occurred threshold times on a thread
+     *
+     * @warning Has to be called before the event sets are built, i.e. before the first Start in persistent mode
+     */
+    void EnableSampling(const int eventCode, const int threshold) override
+    {
+        checkNotInParallelRegion("ENABLE_SAMPLING");
+        checkNoneRunning("ENABLE_SAMPLING");
+        if (multiplexed)
+            handle_error("EnableSampling", "Sampling is not supported for multiplexed events");
+        if (fastRead)
+            handle_error("EnableSampling", "Sampling is not supported in the fast read mode");
+        if (std::find(events.begin(), events.end(), eventCode) == events.end())
+            handle_error("EnableSampling", "The event is not supported or has not been added to the set");
+
+        sampledEvents.push_back({eventCode, threshold});
+    }
+
+    /* Keep the counters of every thread enabled and only read them on Start and Stop. Most useful in persistent mode */
+    bool EnableFastRead() override
+    {
+        checkNotInParallelRegion("ENABLE_FAST_READ");
+        checkNoneRunning("ENABLE_FAST_READ");
+        if (multiplexed || !sampledEvents.empty())
+            handle_error("EnableFastRead", "The fast read mode can not be combined with multiplexing or sampling");
+
+        fastRead = fastReadSupported();
+        if (!fastRead)
+            issue_waring("EnableFastRead", "rdpmc is not available, the counters are started and stopped as before");
+        for (int slot = 0; slot < numSlots; slot++)
+            if (slots[slot]->papi != nullptr && fastRead)
+                slots[slot]->papi->EnableFastRead();
+        return fastRead;
+    }
+
+    /* Print the functions and addresses with the most samples over all threads */
+    void PrintSamples() override
+    {
+        checkNoneRunning("PRINT_SAMPLES");
+#pragma omp single
+        {
+            PapiWrapperSamples *merged = new PapiWrapperSamples();
+            for (int slot = 0; slot < numSlots; slot++)
+                if (slots[slot]->samples != nullptr)
+                    merged->Add(*slots[slot]->samples);
+
+            std::cout << "PAPIW Parallel PapiWrapper sample report:" << std::endl;
+            printSamples(*merged);
+            delete merged;
+        }
+    }
+
+    /* Print the call tree of nested regions. The trees of all threads are merged by call path */
+    void PrintCallTree() override
+    {
+        checkNoneRunning("PRINT_CALL_TREE");
+#pragma omp single
+        {
+            PapiWrapperRegions merged(events.size());
+            mergeRegions(merged);
+            std::cout << "PAPIW Parallel PapiWrapper call tree report:" << std::endl;
+            printCallTree(events, merged.CallTree());
+        }
+    }
+
+protected:
+    void appendThreadResults(const int eventCode, std::vector<long long> &results) override
+    {
+        checkNoneRunning("GET_THREAD_RESULTS");
+
+        int index = getIndex(eventCode);
+        for (int slot = 0; slot < numSlots; slot++)
+            results.push_back(slotResult(slots[slot], index));
+    }
+
+    /* Sum up the named regions of all threads */
+    const PapiWrapperRegions *getRegions() override
+    {
+        if (mergedRegions == nullptr)
+            mergedRegions = new PapiWrapperRegions(events.size());
+        mergedRegions->Reset();
+        mergeRegions(*mergedRegions);
+        return mergedRegions;
+    }
+
+    /* Initialize the instance */
+    void localInit() override
+    {
+        checkNotInParallelRegion("INIT");
+
+        retval = PapiWrapperBackend::Get().ThreadInit();
+        if (retval != PAPI_OK)
+            handle_error("localInit in PapiWrapperParallel", "Could not initialize OMP Support", retval);
+        else
+            std::cout << "Papi Parallel support enabled" << std::endl;
+
+        initSlots();
+    }
+
+    /* Only the slots are needed, the thread support is initialized once by PapiWrapperPasses */
+    void initPass() override
+    {
+        initSlots();
+    }
+
+private:
+    /* Create the slots of the outermost team */
+    void initSlots()
+    {
+        /* Preallocate the slots for the largest outermost team we expect. Elastic slots are created by their threads */
+        outerSlots = elastic ? 0 : omp_get_max_threads();
+        slots.assign(std::max(PAPIW_MAX_THREADS, outerSlots), nullptr);
+        for (numSlots = 0; numSlots < outerSlots; numSlots++)
+            slots[numSlots] = newSlot(1);
+    }
+
+    /* Helper function to start the counters of the calling thread, unless it already counts for an enclosing team */
+    void start()
+    {
+        if (elastic)
+            foldDeparted();
+        if (localPapi != nullptr)
+        {
+            /* In elastic mode, Start inside a parallel region registers threads which are not counting yet */
+            if (localLevel == omp_get_level() && !elastic)
+                handle_error("Start", "You can not start already running Papi counters");
+            return;
+        }
+
+        localSlot = slotOf();
+        if (persistent)
+            releaseRetired();
+        localPapi = persistent ? acquireSlot(localSlot) : createLocalPapi(localSlot);
+        localLevel = omp_get_level();
+        localSlot->running = localPapi;
+        numRunningThreads++;
+
+        localPapi->Start();
+        localSlot->startCpu = localPapi->GetStartCpu();
+    }
+
+    /* Register the calling thread and build its event set */
+    PapiWrapperSingle *createLocalPapi(Slot *slot)
+    {
+        retval = PapiWrapperBackend::Get().RegisterThread();
+        if (retval != PAPI_OK)
+            handle_error("Start", "Couldn't register thread", retval);
+
+        auto papi = new PapiWrapperSingle(pthread_self(), multiplexed);
+        for (auto eventCode : events)
+            papi->AddEvent(eventCode);
+        if (fastRead)
+            papi->EnableFastRead();
+
+        if (!sampledEvents.empty())
+        {
+            if (slot->samples == nullptr)
+                slot->samples = new PapiWrapperSamples();
+            for (auto &sampled : sampledEvents)
+                papi->SampleInto(sampled.first, sampled.second, slot->samples);
+        }
+        return papi;
+    }
+
+    /* Return the event set of a slot and rebuild it only if a different thread owned it */
+    PapiWrapperSingle *acquireSlot(Slot *slot)
+    {
+        if (slot->papi != nullptr && slot->papi->ThreadID == PapiWrapperBackend::Get().ThreadId())
+            return slot->papi;
+
+        /* The previous owner left the team. Its event set is of no use for this thread and is released by its owner */
+        if (slot->papi != nullptr)
+        {
+#pragma omp critical(papiw_retired)
+            retired.push_back(slot->papi);
+            numRetired++;
+        }
+        slot->papi = createLocalPapi(slot);
+
+        /* The initial thread only exits with the process, when there is nothing left to release */
+        if (syscall(SYS_gettid) != getpid())
+            exitHandler.lifetime = lifetime;
+        return slot->papi;
+    }
+
+    /* Take the retired event sets of the calling thread out of the list. Optionally also the event sets of the slots it owns */
+    std::vector<PapiWrapperSingle *> takeOwned(const bool withSlots)
+    {
+        std::vector<PapiWrapperSingle *> owned;
+        unsigned long thread = PapiWrapperBackend::Get().ThreadId();
+#pragma omp critical(papiw_retired)
+        {
+            for (auto papi = retired.begin(); papi != retired.end();)
+                if ((*papi)->ThreadID == thread)
+                {
+                    owned.push_back(*papi);
+                    papi = retired.erase(papi);
+                    numRetired--;
+                }
+                else
+                    ++papi;
+
+            for (int slot = 0; withSlots && slot < numSlots; slot++)
+                if (slots[slot]->papi != nullptr && slots[slot]->papi->ThreadID == thread)
+                {
+                    owned.push_back(slots[slot]->papi);
+                    slots[slot]->papi = nullptr;
+                }
+        }
+        return owned;
+    }
+
+    /* Destroy the event sets the calling thread created for slots which were taken over by other threads */
+    void releaseRetired()
+    {
+        if (numRetired == 0)
+            return;
+        for (auto papi : takeOwned(false))
+            delete papi;
+    }
+
+    /* Fold in the counters of the exiting thread if it left the team while counting and release its idle event sets. Holds the lifetime lock */
+    void threadExit()
+    {
+        if (localPapi != nullptr && localSlot->running == localPapi && localPapi->IsRunning())
+        {
+            localSlot->running = nullptr;
+            numRunningThreads--;
+            finishInterval();
+            if (elastic)
+                harvestedThreads++;
+        }
+        else if (elastic)
+            foldDeparted();
+
+        if (localPapi == nullptr)
+            releaseOwned();
+    }
+
+    /* Destroy all event sets of the calling thread and unregister it */
+    void releaseOwned()
+    {
+        auto owned = takeOwned(true);
+        for (auto papi : owned)
+            delete papi;
+        if (owned.empty())
+            return;
+
+        retval = PapiWrapperBackend::Get().UnregisterThread();
+        if (retval != PAPI_OK)
+            handle_error("~PapiWrapperParallel", "Couldn't unregister thread", retval);
+    }
+
+    /* Helper function to stop the counters and accumulate the values to the slot of the thread */
+    void stop()
+    {
+        if (elastic)
+        {
+            foldDeparted();
+
+            /* The thread joined the team after it was started and did not register */
+            if (localPapi == nullptr)
+                return;
+        }
+
+        /* The counters of the thread belong to an enclosing team */
+        if (localPapi != nullptr && localLevel != omp_get_level())
+            return;
+        if (localPapi == nullptr)
+            handle_error("Stop", "The Papi counters of this thread are not running. Nested parallel regions may move the threads of a team, start and stop the counters inside the outermost parallel region instead");
+
+        localSlot->running = nullptr;
+        numRunningThreads--;
+        finishInterval();
+    }
+
+    /* Stop the counters of the calling thread and accumulate the values of the interval to its slot */
+    void finishInterval()
+    {
+        localPapi->Stop();
+
+        /*Check that same thread is used since starting the counters*/
+        if (PapiWrapperBackend::Get().ThreadId() != localPapi->ThreadID)
+            handle_error("Stop", "Invalid State: The Thread Ids differs from initialization!\nApparently, new threads were use without reassigning the Papi counters. Please Start and Stop more often to avoid this error.");
+
+        /* Every thread owns its slot, so no synchronization is needed */
+        Slot *slot = localSlot;
+        slot->stopCpu = localPapi->GetStopCpu();
+        if (slot->stopCpu != slot->startCpu)
+            slot->migrations++;
+        accumulate(slot, localPapi);
+        slot->Value(events.size() + 1) += localPapi->GetVirtTime();
+
+        /* Keep the event set for the next Start, only the intermediate values have to go */
+        if (persistent)
+        {
+            localPapi->Reset();
+            localPapi = nullptr;
+            return;
+        }
+
+        delete localPapi;
+        localPapi = nullptr;
+
+        retval = PapiWrapperBackend::Get().UnregisterThread();
+        if (retval != PAPI_OK)
+            handle_error("Stop", "Couldn't unregister thread", retval);
+    }
+
+    /* Helper function to begin a region on the calling thread, starting its counters if necessary */
+    void beginRegion(const PAPIW::RegionName &name)
+    {
+        Slot *slot = slotOf();
+        if (slot->regions == nullptr)
+            slot->regions = new PapiWrapperRegions(events.size());
+
+        /* Threads which join a running elastic team are registered by their first region */
+        if (elastic)
+        {
+            foldDeparted();
+            if (localPapi == nullptr && elasticRunning)
+                start();
+        }
+
+        /* localPapi is only set while the counters of this thread are running */
+        bool owner = localPapi == nullptr;
+        if (owner)
+        {
+            localSlot = slot;
+            localPapi = persistent ? acquireSlot(slot) : createLocalPapi(slot);
+            localLevel = omp_get_level();
+            localPapi->StartCounters();
+        }
+
+        long long *snapshot = slot->regions->Enter(name, owner);
+        if (snapshot == nullptr)
+            handle_error("BeginRegion", "Too many regions. Check PAPIW_MAX_REGIONS and PAPIW_MAX_REGION_DEPTH");
+        PapiWrapperEnergy::Begin(name.hash, name.name);
+        localPapi->Read(snapshot);
+    }
+
+    /* Helper function to end a region on the calling thread, stopping its counters if they were started by it */
+    void endRegion(const PAPIW::RegionName &name)
+    {
+        auto regions = slotOf()->regions;
+        if (regions == nullptr || regions->Depth() == 0 || localPapi == nullptr)
+            handle_error("EndRegion", "There is no region to end");
+
+        bool owner = regions->IsOwner();
+        long long *current = regions->Scratch();
+        localPapi->Read(current);
+        PapiWrapperTrace::Append(name.hash, name.name, current, events.size(), regions->Snapshot());
+        PapiWrapperDistribution::Record(name.hash, name.name, current, events.size(), regions->Snapshot());
+        if (!regions->Leave(name, current))
+            handle_error("EndRegion", "Regions have to be ended in the reverse order they were begun");
+        PapiWrapperEnergy::End(name.hash);
+
+        if (!owner)
+            return;
+
+        localPapi->StopCounters();
+        if (!persistent)
+        {
+            delete localPapi;
+            retval = PapiWrapperBackend::Get().UnregisterThread();
+            if (retval != PAPI_OK)
+                handle_error("EndRegion", "Couldn't unregister thread", retval);
+        }
+        localPapi = nullptr;
+    }
+
+    /* Add the values of a stopped event set to a slot, except for the virtual time which is only known to its thread */
+    void accumulate(Slot *slot, PapiWrapperSingle *papi)
+    {
+        int eventCount = events.size();
+        for (int i = 0; i < eventCount; i++)
+            slot->Value(i) += papi->GetResult(events[i]);
+        slot->Value(eventCount) += papi->GetEnabledTime();
+        slot->Value(eventCount + 2)++;
+
+        auto &cpuValues = slot->cpuValues[slot->startCpu];
+        cpuValues.resize(eventCount + 1, 0);
+        for (int i = 0; i < eventCount; i++)
+            cpuValues[i] += papi->GetResult(events[i]);
+        cpuValues[eventCount]++;
+    }
+
+    /**
+     * Mark the threads which left the elastic team while counting. Their event sets are bound to them, so they
+     * stop their counters and fold the values in themselves, when they take part in the next team
+     */
+    void harvest()
+    {
+        /* Threads which exit meanwhile fold their values in themselves */
+        std::lock_guard<std::mutex> lock(lifetime->mutex);
+        for (int i = 0; i < numSlots; i++)
+        {
+            Slot *slot = slots[i];
+            if (slot->running == nullptr)
+                continue;
+
+            slot->running = nullptr;
+            slot->departed.store(true, std::memory_order_release);
+            pendingThreads++;
+            numRunningThreads--;
+        }
+        elasticRunning = false;
+    }
+
+    /* Stop the counters the calling thread left running when it departed from the elastic team and fold their values in */
+    void foldDeparted()
+    {
+        if (localPapi == nullptr || !localSlot->departed.load(std::memory_order_acquire))
+            return;
+
+        finishInterval();
+        localSlot->departed.store(false, std::memory_order_relaxed);
+        harvestedThreads++;
+        pendingThreads--;
+    }
+
+    /**
+     * Get the slot of the calling thread. The thread numbers of all levels identify a thread, where the trailing
+     * levels on which it is the master are left out, since it is the same thread as on the enclosing level.
+     * In elastic mode, the OS thread identifies the slot
+     *
+     * @param create If false, nullptr is returned for threads without a slot instead of allocating one
+     */
+    Slot *slotOf(const bool create = true)
+    {
+        if (elastic)
+            return threadSlot(create);
+
+        int depth = omp_get_level();
+        while (depth > 0 && omp_get_ancestor_thread_num(depth) == 0)
+            depth--;
+
+        if (depth == 0)
+            return slots[0];
+        if (depth == 1 && omp_get_ancestor_thread_num(1) < outerSlots)
+            return slots[omp_get_ancestor_thread_num(1)];
+
+        std::vector<int> path(depth);
+        for (int level = 1; level <= depth; level++)
+            path[level - 1] = omp_get_ancestor_thread_num(level);
+
+        Slot *slot;
+#pragma omp critical(papiw_slots)
+        {
+            auto nested = nestedSlots.find(path);
+            if (nested == nestedSlots.end() && create)
+            {
+                if (numSlots == static_cast<int>(slots.size()))
+                    handle_error("Start", "Too many threads in nested teams. Check PAPIW_MAX_THREADS");
+                slots[numSlots] = newSlot(depth);
+                nested = nestedSlots.emplace(path, numSlots++).first;
+            }
+            slot = nested == nestedSlots.end() ? nullptr : slots[nested->second];
+        }
+        return slot;
+    }
+
+    /* Get the slot of the calling OS thread, which is created on its first use (elastic mode only) */
+    Slot *threadSlot(const bool create)
+    {
+        unsigned long thread = pthread_self();
+        Slot *slot;
+#pragma omp critical(papiw_slots)
+        {
+            auto known = threadSlots.find(thread);
+            if (known == threadSlots.end() && create)
+            {
+                if (numSlots == static_cast<int>(slots.size()))
+                    handle_error("Start", "Too many threads. Check PAPIW_MAX_THREADS");
+                slots[numSlots] = newSlot(std::max(omp_get_level(), 1));
+                known = threadSlots.emplace(thread, numSlots++).first;
+            }
+            slot = known == threadSlots.end() ? nullptr : slots[known->second];
+        }
+        return slot;
+    }
+
+    /* Allocate a slot for a thread of a team on the given nesting level */
+    Slot *newSlot(const int level)
+    {
+        Slot *slot = new Slot();
+        slot->level = level;
+        layoutSlot(slot);
+        return slot;
+    }
+
+    /* Reallocate the values of a slot for the current events, keeping the old values */
+    void layoutSlot(Slot *slot)
+    {
+        /* The three values after the last event hold the enabled time, the virtual time and the number of intervals of the thread */
+        slot->lines.resize((events.size() + 2 + valuesPerLine) / valuesPerLine, CacheLine{});
+    }
+
+    /* Sum up the named regions of all threads */
+    void mergeRegions(PapiWrapperRegions &merged)
+    {
+        bool complete = true;
+        for (int slot = 0; slot < numSlots; slot++)
+            if (slots[slot]->regions != nullptr)
+                complete = merged.Add(*slots[slot]->regions) && complete;
+        if (!complete)
+            issue_waring("Print", "The threads use too many distinct regions, some are skipped. Check PAPIW_MAX_REGIONS");
+    }
+
+    /* Value of an event of a slot, corrected by the calibrated overhead if enabled */
+    long long slotResult(Slot *slot, const int index)
+    {
+        if (!correctOverhead)
+            return slot->Value(index);
+
+        long long overhead = slot->overhead.empty() ? GetOverhead(events[index]) : slot->overhead[index];
+        return std::max(0LL, slot->Value(index) - overhead * slot->Value(events.size() + 2));
+    }
+
+    /**
+     * Sum up the events and intervals of all threads by a key of the cpu the intervals were started on,
+     * e.g. the socket. Corrected by the calibrated overhead like the totals
+     */
+    template <typename Key, typename KeyOf>
+    std::map<Key, std::vector<long long>> aggregate(KeyOf keyOf)
+    {
+        auto &cpus = getTopology();
+        int count = events.size();
+        std::map<Key, std::vector<long long>> results;
+        for (int slot = 0; slot < numSlots; slot++)
+        {
+            for (auto &cpu : slots[slot]->cpuValues)
+            {
+                auto &values = results[keyOf(cpus.Get(cpu.first))];
+                values.resize(count + 1, 0);
+                long long intervals = cpu.second[count];
+                for (int i = 0; i < count; i++)
+                {
+                    long long overhead = 0;
+                    if (correctOverhead)
+                        overhead = slots[slot]->overhead.empty() ? GetOverhead(events[i]) : slots[slot]->overhead[i];
+                    values[i] += std::max(0LL, cpu.second[i] - overhead * intervals);
+                }
+                values[count] += intervals;
+            }
+        }
+        return results;
+    }
+
+    PapiWrapperTopology &getTopology()
+    {
+        if (topology == nullptr)
+            topology = new PapiWrapperTopology();
+        return *topology;
+    }
+
+    /* Print how many threads contributed to the results, how many of them were harvested and how many harvested threads did not fold their values in yet */
+    void printContributors()
+    {
+        int contributors = 0;
+        for (int slot = 0; slot < numSlots; slot++)
+            if (slots[slot]->Value(events.size() + 2) != 0)
+                contributors++;
+
+        std::cout << "Contributing threads: " << contributors << " (harvested: " << harvestedThreads << ", pending: " << pendingThreads << ")" << std::endl;
+        std::cout << "@%N " << contributors << " " << harvestedThreads << " " << pendingThreads << std::endl;
+    }
+
+    /* Deepest nesting level of all slots */
+    int maxLevel()
+    {
+        int deepest = 1;
+        for (int slot = 0; slot < numSlots; slot++)
+            deepest = std::max(deepest, slots[slot]->level);
+        return deepest;
+    }
+
+    /* Print the values of every nesting level, if nested teams were counted */
+    void printLevels(const std::vector<int> &events)
+    {
+        int levels = maxLevel();
+        if (levels == 1)
+            return;
+
+        std::vector<std::vector<long long>> results;
+        for (auto eventCode : events)
+            results.push_back(GetLevelResults(eventCode));
+
+        int count = events.size();
+        for (int level = 0; level < levels; level++)
+        {
+            std::cout << "Nesting level " << level + 1 << ":" << std::endl;
+            for (int i = 0; i < count; i++)
+                std::cout << "  " << getDescription(events[i]) << ": " << results[i][level] << std::endl;
+        }
+        for (int level = 0; level < levels; level++)
+        {
+            std::cout << "@%L " << level + 1;
+            for (int i = 0; i < count; i++)
+                std::cout << " " << results[i][level];
+            std::cout << std::endl;
+        }
+    }
+
+    /* Get the position of an event or exit with an error if it has not been added */
+    int getIndex(const int eventCode)
+    {
+        auto indexInResult = std::find(events.begin(), events.end(), eventCode);
+        if (indexInResult == events.end())
+            handle_error("GetResult", "The event is not supported or has not been added to the set");
+
+        return indexInResult - events.begin();
+    }
+
+    /* Returns the current OMP team size */
+    int GetNumThreads()
+    {
+        if (isInParallelRegion())
+            return omp_get_num_threads();
+
+        int count;
+#pragma omp parallel
+        {
+#pragma omp master
+            count = omp_get_num_threads();
+        }
+        return count;
+    }
+
+    /* Returns true if it is called in a parallel region or false otherwise */
+    bool isInParallelRegion()
+    {
+        return omp_get_level() != 0;
+    }
+
+    /* Check that the outermost team size is the same as in Start or exit with an error otherwise */
+    void checkNumberOfThreads(const char *actionMsg)
+    {
+        /* State check */
+        if (GetNumThreads() != startedThreads)
+            handle_error(actionMsg, "The OMP teamsize is different than indicated in Start!");
+    }
+
+    /* Check that this method is not called from a parallel context or exit with an error otherwise */
+    void checkNotInParallelRegion(const char *actionMsg)
+    {
+        if (isInParallelRegion())
+            handle_error(actionMsg, "You may not perform this operation from a parallel region");
+    }
+
+    /* Check that no Papi Counter is running or exit with an error otherwise */
+    void checkNoneRunning(const char *actionMsg)
+    {
+        if (numRunningThreads)
+            handle_error(actionMsg, "You can not perform this action while Papi is running. Stop the counters first!");
+    }
+};
+#endif
+
+/**
+ * PapiWrapper class for event lists which do not fit into one event set
+ *
+ * The events are partitioned into groups which can be counted together. Every group has its own
+ * PapiWrapperSingle or PapiWrapperParallel, which counts a pass of MeasurePasses. The results of all passes
+ * are merged, s.t. every event is counted exactly instead of being estimated as with multiplexing.
+ *
+ * It is discoureaged to use this class directly but rather through the utility functions
+ * inside the PAPIW namespace.
+ */
+class PapiWrapperPasses : public PapiWrapper
+{
+private:
+    std::vector<int> requested;         // Events in the order of Init
+    std::vector<int> events;            // Planned events in the order of Init
+    std::vector<PapiWrapper *> passes;  // One wrapper per group of events
+    std::vector<int> passOfEvent;       // Index of the pass counting every event
+    std::vector<std::vector<int>> columns; // Position of the events of every pass in events
+    PapiWrapperRegions *mergedRegions = nullptr;
+    int current = 0; // Pass which is counted by Start and Stop
+    bool planned = false;
+    const bool parallel;
+
+public:
+    /* @param parallel If true, every pass counts all threads of the omp team */
+    PapiWrapperPasses(const bool parallel = false) : parallel(parallel)
+    {
+        mode = parallel ? "parallel" : "single";
+    }
+    ~PapiWrapperPasses()
+    {
+        for (auto pass : passes)
+            delete pass;
+        delete mergedRegions;
+    }
+
+    /* Register events to be counted. They are planned once all events of Init are known */
+    void AddEvent(const int eventCode) override
+    {
+        if (planned)
+            handle_error("AddEvent", "Events of multiple passes can only be added in Init");
+        requested.push_back(eventCode);
+    }
+
+    /* Get the number of passes */
+    int GetNumPasses()
+    {
+        return passes.size();
+    }
+
+    /* Start the counters of the current pass */
+    void Start() override
+    {
+        if (distribution != nullptr)
+            distribution->SetColumns(&columns[current]);
+        passes[current]->Start();
+    }
+
+    /* Stop the counters of the current pass */
+    void Stop() override
+    {
+        passes[current]->Stop();
+    }
+
+    /* Run the function once per pass */
+    void MeasurePasses(const std::function<void()> &function) override
+    {
+        for (current = 0; current < GetNumPasses(); current++)
+        {
+            Start();
+            function();
+            Stop();
+        }
+        current = 0;
+    }
+
+    /* Get the result of a specific event */
+    long long GetResult(const int eventCode) override
+    {
+        return passes[getPass(eventCode)]->GetResult(eventCode);
+    }
+
+    /* Copy the results of all events in the order of GetEvents() into results */
+    void GetResults(long long *results) override
+    {
+        int count = events.size();
+        for (int i = 0; i < count; i++)
+            results[i] = passes[passOfEvent[i]]->GetResult(events[i]);
+    }
+
+    /* Get the result of an event for every thread of the pass which counted it */
+    std::vector<long long> GetThreadResults(const int eventCode) override
+    {
+        return passes[getPass(eventCode)]->GetThreadResults(eventCode);
+    }
+
+    /* Get the result of an event for every nesting level of the pass which counted it */
+    std::vector<long long> GetLevelResults(const int eventCode) override
+    {
+        return passes[getPass(eventCode)]->GetLevelResults(eventCode);
+    }
+
+    /* Get the result of an event for every socket from the pass which counted it */
+    std::vector<long long> GetSocketResults(const int eventCode) override
+    {
+        return passes[getPass(eventCode)]->GetSocketResults(eventCode);
+    }
+
+    /* Get the codes of the counted events */
+    const std::vector<int> &GetEvents() override
+    {
+        return events;
+    }
+
+    /* Average over all passes, since every pass runs the same function */
+    long long GetEnabledTime() override
+    {
+        return average([](PapiWrapper *pass) { return pass->GetEnabledTime(); });
+    }
+
+    /* Average over all passes, since every pass runs the same function */
+    long long GetRealTime() override
+    {
+        return average([](PapiWrapper *pass) { return pass->GetRealTime(); });
+    }
+
+    /* Average over all passes, since every pass runs the same function */
+    long long GetVirtTime() override
+    {
+        return average([](PapiWrapper *pass) { return pass->GetVirtTime(); });
+    }
+
+    /* Reset the values of all passes */
+    void Reset() override
+    {
+        for (auto pass : passes)
+            pass->Reset();
+    }
+
+    /* Calibrate every pass */
+    void Calibrate(const int repetitions) override
+    {
+        for (auto pass : passes)
+            pass->Calibrate(repetitions);
+        correctOverhead = true;
+    }
+
+    /* Get the calibrated overhead from the pass which counts the event */
+    long long GetOverhead(const int eventCode) override
+    {
+        return passes[getPass(eventCode)]->GetOverhead(eventCode);
+    }
+
+    /* Get the result of a specific event without the overhead correction */
+    long long GetRawResult(const int eventCode) override
+    {
+        return passes[getPass(eventCode)]->GetRawResult(eventCode);
+    }
+
+    /* Correct the results of every pass */
+    void CorrectOverhead(const bool enabled) override
+    {
+        correctOverhead = enabled;
+        for (auto pass : passes)
+            pass->CorrectOverhead(enabled);
+    }
+
+    /* Print the merged results */
+    void Print() override
+    {
+        if (printText)
+        {
+            std::vector<long long> totals(events.size());
+            GetResults(totals.data());
+
+            std::cout << "PAPIW Passes PapiWrapper instance report (" << passes.size() << " passes):" << std::endl;
+            print(events, totals.data());
+            printOverhead(events);
+            printMetrics(totals.data());
+        }
+        exportOnPrint();
+    }
+
+    /* Print the values of every thread */
+    void PrintThreads() override
+    {
+        std::cout << "PAPIW Passes PapiWrapper thread report:" << std::endl;
+        printThreads(events);
+    }
+
+    /* Begin a named region in the current pass */
+    void BeginRegion(const PAPIW::RegionName &name) override
+    {
+        passes[current]->BeginRegion(name);
+    }
+
+    /* End a named region in the current pass */
+    void EndRegion(const PAPIW::RegionName &name) override
+    {
+        passes[current]->EndRegion(name);
+    }
+
+    /* Get the value of an event inside a region from the pass which counted it */
+    long long GetRegionResult(const PAPIW::RegionName &name, const int eventCode) override
+    {
+        return passes[getPass(eventCode)]->GetRegionResult(name, eventCode);
+    }
+
+    /* Print the merged results of all named regions */
+    void PrintRegions() override
+    {
+        std::cout << "PAPIW Passes PapiWrapper region report:" << std::endl;
+        printRegions(events, *getRegions());
+    }
+
+    /* Print the call tree of every pass */
+    void PrintCallTree() override
+    {
+        for (int pass = 0; pass < GetNumPasses(); pass++)
+        {
+            std::cout << "Pass " << pass << ":" << std::endl;
+            passes[pass]->PrintCallTree();
+        }
+    }
+
+    /* Sample the event in the pass which counts it */
+    void EnableSampling(const int eventCode, const int threshold) override
+    {
+        passes[getPass(eventCode)]->EnableSampling(eventCode, threshold);
+    }
+
+    /* Use the fast read mode in every pass */
+    bool EnableFastRead() override
+    {
+        bool enabled = true;
+        for (auto pass : passes)
+            enabled = pass->EnableFastRead() && enabled;
+        return enabled;
+    }
+
+    /* Print the samples of every pass */
+    void PrintSamples() override
+    {
+        for (auto pass : passes)
+            pass->PrintSamples();
+    }
+
+protected:
+    void appendThreadResults(const int eventCode, std::vector<long long> &results) override
+    {
+        passes[getPass(eventCode)]->appendThreadResults(eventCode, results);
+    }
+
+    /* Threads have to be supported before the planner creates its trial event sets */
+    void localInit() override
+    {
+        if (!parallel)
+            return;
+
+        retval = PapiWrapperBackend::Get().ThreadInit();
+        if (retval != PAPI_OK)
+            handle_error("localInit in PapiWrapperPasses", "Could not initialize OMP Support", retval);
+    }
+
+    /* Partition the events into passes */
+    void eventsAdded() override
+    {
+        std::vector<int> skipped;
+        auto groups = PapiWrapperPlanner::Plan(requested, skipped);
+        for (auto eventCode : skipped)
+        {
+            char name[PAPI_MAX_STR_LEN];
+            if (PapiWrapperBackend::Get().EventCodeToName(eventCode, name) != PAPI_OK)
+                snprintf(name, sizeof(name), "0x%x", eventCode);
+            issue_waring("Init. Could not add", name);
+        }
+
+        for (auto &group : groups)
+        {
+#ifdef _OPENMP
+            PapiWrapper *pass = parallel ? static_cast<PapiWrapper *>(new PapiWrapperParallel()) : new PapiWrapperSingle();
+#else
+            PapiWrapper *pass = new PapiWrapperSingle();
+#endif
+            pass->initPass();
+            for (auto eventCode : group)
+                pass->AddEvent(eventCode);
+            pass->eventTable.Build(pass->GetEvents());
+            passes.push_back(pass);
+        }
+
+        /* Keep the order of Init */
+        columns.resize(groups.size());
+        for (auto eventCode : requested)
+            for (size_t pass = 0; pass < groups.size(); pass++)
+                if (std::find(groups[pass].begin(), groups[pass].end(), eventCode) != groups[pass].end() &&
+                    std::find(events.begin(), events.end(), eventCode) == events.end())
+                {
+                    passOfEvent.push_back(pass);
+                    events.push_back(eventCode);
+                }
+        for (size_t pass = 0; pass < groups.size(); pass++)
+            for (auto eventCode : passes[pass]->GetEvents())
+                columns[pass].push_back(std::find(events.begin(), events.end(), eventCode) - events.begin());
+
+        planned = true;
+        if (passes.empty())
+            handle_error("Init", "None of the events can be counted");
+    }
+
+    /* Merge the regions of all passes */
+    const PapiWrapperRegions *getRegions() override
+    {
+        if (mergedRegions == nullptr)
+            mergedRegions = new PapiWrapperRegions(events.size());
+        mergedRegions->Reset();
+        bool complete = true;
+        for (int pass = 0; pass < GetNumPasses(); pass++)
+        {
+            auto regions = passes[pass]->getRegions();
+            if (regions != nullptr)
+                complete = mergedRegions->AddPass(*regions, columns[pass]) && complete;
+        }
+        if (!complete)
+            issue_waring("Print", "The passes use too many distinct regions, some are skipped. Check PAPIW_MAX_REGIONS");
+        return mergedRegions;
+    }
+
+private:
+    /* Get the pass which counts an event or exit with an error */
+    int getPass(const int eventCode)
+    {
+        auto indexInResult = std::find(events.begin(), events.end(), eventCode);
+        if (indexInResult == events.end())
+            handle_error("GetResult", "The event is not supported or has not been added to the set");
+        return passOfEvent[indexInResult - events.begin()];
+    }
+
+    /* Average of a time over all passes */
+    long long average(long long (*time)(PapiWrapper *))
+    {
+        long long sum = 0;
+        for (auto pass : passes)
+            sum += time(pass);
+        return passes.empty() ? 0 : sum / static_cast<long long>(passes.size());
+    }
+};
+
+
+/**
+ * PapiWrapper class for any threading model, e.g. std::thread, pthreads or thread pools
+ *
+ * Every thread registers lazily at Papi on its first Start and keeps its event set in thread_local state
+ * until it exits. Threads start and stop their own counters independently of each other. The values of
+ * all threads which ever counted are kept after they exited and are summed up without locks.
+ *
+ * The results, times and Print may be queried while other threads count and hold the completed intervals.
+ * Regions, samples and everything which changes the configuration need all threads to be stopped.
+ *
+ * It is discoureaged to use this class directly but rather through the utility functions
+ * inside the PAPIW namespace.
+ */
+class PapiWrapperThreads : public PapiWrapper
+{
+private:
+    /* Counters and values of one thread. The instance and the thread share it, the last one to let go deletes it */
+    struct alignas(PAPIW_CACHE_LINE_SIZE) ThreadState
+    {
+        PapiWrapperSingle *papi = nullptr;       // Event set of the thread, only touched by the thread itself
+        std::vector<int> events;                 // Events the event set was built for
+        std::vector<long long> values;           // Accumulated values of the events, only written by the thread
+        long long enabledTime = 0;
+        long long virtTime = 0;
+        long long intervals = 0;                 // Number of Start/Stop pairs
+        unsigned generation = 0;                 // Configuration the event set was built for
+        PapiWrapperRegions *regions = nullptr;   // Named regions of the thread, created on first use
+        PapiWrapperSamples *samples = nullptr;   // Instruction pointer samples of the thread
+        std::atomic<bool> running{false};
+        std::atomic<int> references{2};
+        std::atomic<unsigned> sequence{0};       // Odd while the thread accumulates its values
+        ThreadState *next = nullptr;
+
+        ~ThreadState()
+        {
+            delete regions;
+            delete samples;
+        }
+
+        /* Stop the counters and accumulate their values */
+        void Stop()
+        {
+            papi->Stop();
+            unsigned begin = sequence.load(std::memory_order_relaxed) + 1;
+            sequence.store(begin, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            int count = events.size();
+            for (int i = 0; i < count; i++)
+                values[i] += papi->GetResult(events[i]);
+            enabledTime += papi->GetEnabledTime();
+            virtTime += papi->GetVirtTime();
+            intervals++;
+            sequence.store(begin + 1, std::memory_order_release);
+            papi->Reset();
+            running.store(false, std::memory_order_release);
+        }
+
+        /* Run read on the values of the completed intervals, again if the thread accumulated them meanwhile */
+        template <typename Read>
+        void ReadCompleted(Read read) const
+        {
+            unsigned before, after;
+            do
+            {
+                before = sequence.load(std::memory_order_acquire);
+                read();
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence.load(std::memory_order_relaxed);
+            } while ((before & 1) != 0 || before != after);
+        }
+
+        void Release()
+        {
+            if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete this;
+        }
+    };
+
+    /* States of the calling thread for every instance. Releases the event sets when the thread exits */
+    struct ThreadRegistry
+    {
+        std::vector<std::pair<unsigned long, ThreadState *>> states; // Instance id and state
+        bool registered;                                              // True if the thread is registered at Papi
+
+        ThreadRegistry() : registered(false) {}
+        ~ThreadRegistry()
+        {
+            for (auto &entry : states)
+            {
+                auto state = entry.second;
+                if (state->running.load(std::memory_order_acquire))
+                {
+                    if (state->regions != nullptr && state->regions->Depth() != 0)
+                        fprintf(stderr, "PAPI WARNING in ThreadExit: A thread exited inside a region. Its values since the region was begun are lost\n");
+                    else
+                        state->Stop();
+                    state->running.store(false, std::memory_order_release);
+                }
+                delete state->papi;
+                state->papi = nullptr;
+                state->Release();
+            }
+            if (registered)
+                PapiWrapperBackend::Get().UnregisterThread();
         }
-    }
-};
+    };
 
-/**
- * PapiWrapper class for Sequential use
- * 
- * It is discoureaged to use this class directly but rather through the utility functions
- * inside the PAPIW namespace.
- */
-class PapiWrapperSingle : public PapiWrapper
-{
-private:
-    static int const papiMaxAllowedCounters = 20;
-    int eventSet = PAPI_NULL;
-    bool running = false;
-    long long buffer[papiMaxAllowedCounters];
-    long long values[papiMaxAllowedCounters];
+    inline static thread_local ThreadRegistry registry;
+    inline static std::atomic<unsigned long> nextId{0};
+
+    const unsigned long id; // Identifies the instance in the registries of the threads
     std::vector<int> events;
+    std::atomic<ThreadState *> states{nullptr};     // Every thread which ever counted, newest first
+    unsigned generation = 0;                         // Increased whenever the event sets have to be rebuilt
+    std::vector<std::pair<int, int>> sampledEvents;  // Event code and threshold of every sampled event
+    std::vector<long long> overhead;                 // Calibrated overhead of every event, measured on one thread
+    PapiWrapperRegions *mergedRegions = nullptr;     // Sum of the regions of all threads, reused by every export
+    bool fastRead = false;
 
 public:
-    PapiWrapperSingle() : ThreadID(0) {}
-    PapiWrapperSingle(const unsigned long threadID) : ThreadID(threadID) {}
-    ~PapiWrapperSingle() {}
-
-    const unsigned long ThreadID;
-
-    /* Add an event to be counted */
-    void AddEvent(const int eventCode) override
+    /**
+     * @param multiplexed If true, the events share the hardware counters and the values are scaled estimates
+     */
+    PapiWrapperThreads(const bool multiplexed = false) : PapiWrapper(multiplexed), id(nextId++)
     {
-        if (running)
-            handle_error("AddEvent", "You can't add events while Papi is running\n");
-
-        if (events.size() >= papiMaxAllowedCounters)
-            handle_error("AddEvent", "Event count limit exceeded. Check papiMaxAllowedCounters\n");
+        mode = "threads";
+    }
 
-        if (eventSet == PAPI_NULL)
+    /* Event sets of other threads which are still alive are released on their next use of an instance or when they exit */
+    ~PapiWrapperThreads()
+    {
+        auto state = states.load(std::memory_order_acquire);
+        while (state != nullptr)
         {
-            retval = PAPI_create_eventset(&eventSet);
-            if (retval != PAPI_OK)
-                handle_error("AddEvent", "Could not create event set", retval);
+            auto next = state->next;
+            state->Release();
+            state = next;
         }
+        prune();
+        delete mergedRegions;
+    }
 
-        retval = PAPI_add_event(eventSet, eventCode);
-        if (retval != PAPI_OK)
-            issue_waring("AddEvent. Could not add", getDescription(eventCode), retval);
-        else
-            events.push_back(eventCode);
+    /* Register events to be counted */
+    void AddEvent(const int eventCode) override
+    {
+        checkNoneRunning("ADD_EVENT");
+        if (!queryEvent(eventCode))
+            return;
+        events.push_back(eventCode);
+        overhead.clear();
+        generation++;
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            state->values.resize(events.size(), 0);
     }
 
-    /* Start the counter */
+    /* Start the counters of the calling thread */
     void Start() override
     {
-        if (running)
-            handle_error("Start", "You can not start an already running PAPI instance");
-
-        retval = PAPI_start(eventSet);
-        if (retval != PAPI_OK)
-            handle_error("Start", "Could not start PAPI counters", retval);
-
-        running = true;
+        auto state = localState();
+        if (state->running.load(std::memory_order_relaxed))
+            handle_error("Start", "The counters of this thread are already running");
+        start(state);
     }
 
-    /* Stop the counter */
+    /* Stop the counters of the calling thread and accumulate its values */
     void Stop() override
     {
-        if (!running)
-            handle_error("Stop", "You can not stop an already stopped Papi instance");
+        auto state = localState();
+        if (!state->running.load(std::memory_order_relaxed))
+            handle_error("Stop", "The counters of this thread are not running");
+        state->Stop();
+    }
 
-        retval = PAPI_stop(eventSet, buffer);
-        if (retval != PAPI_OK)
-            handle_error("Stop", "Could not stop PAPI counters", retval);
+    /* Get the result of a specific event summed up over all threads, of their completed intervals */
+    long long GetResult(const int eventCode) override
+    {
+        int index = getIndex(eventCode);
+        long long total = 0;
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            total += threadResult(state, index);
+        return total;
+    }
 
-        int count = events.size();
-        for (int i = 0; i < count; i++)
-            values[i] += buffer[i];
+    /* Copy the results of all events in the order of GetEvents() into results, summed up over all threads */
+    void GetResults(long long *results) override
+    {
+        std::fill(results, results + events.size(), 0);
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            for (size_t index = 0; index < events.size(); index++)
+                results[index] += threadResult(state, index);
+    }
 
-        running = false;
+    /* Get the result of a specific event without the overhead correction */
+    long long GetRawResult(const int eventCode) override
+    {
+        int index = getIndex(eventCode);
+        long long total = 0;
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            total += completed(state, [state, index]() { return state->values[index]; });
+        return total;
     }
 
-    /* Get the result of a specific event */
-    long long GetResult(const int eventCode) override
+    /**
+     * Measure empty Start/Stop pairs on the calling thread. Every thread runs the same code path,
+     * so its overhead is applied to the intervals of all threads. The values counted so far are reset
+     */
+    void Calibrate(const int repetitions) override
     {
-        if (running)
-            handle_error("GetResult", "You can't get results while Papi is running\n");
+        checkNoneRunning("CALIBRATE");
 
-        auto indexInResult = std::find(events.begin(), events.end(), eventCode);
-        if (indexInResult == events.end())
-            handle_error("GetResult", "The event is not supported or has not been added to the set");
+        auto state = localState();
+        if (state->generation != generation)
+            build(state);
+        state->papi->Calibrate(repetitions);
+        state->papi->CorrectOverhead(false);
 
-        return values[indexInResult - events.begin()];
+        overhead.clear();
+        for (auto eventCode : events)
+            overhead.push_back(state->papi->GetOverhead(eventCode));
+        Reset();
+        correctOverhead = true;
     }
 
-    /* Reset the intermediate counter values */
-    void Reset()
+    /* Get the calibrated overhead of one Start/Stop pair */
+    long long GetOverhead(const int eventCode) override
     {
-        if (running)
-            handle_error("Reset", "You can't reset while Papi is running\n");
-
-        localInit();
+        int index = getIndex(eventCode);
+        return overhead.empty() ? 0 : overhead[index];
     }
 
-    /* Getter Method for running state */
-    bool IsRunning()
+    /* Keep the counters of every thread enabled and only read them on Start and Stop */
+    bool EnableFastRead() override
     {
-        return running;
+        checkNoneRunning("ENABLE_FAST_READ");
+        if (multiplexed || !sampledEvents.empty())
+            handle_error("EnableFastRead", "The fast read mode can not be combined with multiplexing or sampling");
+
+        fastRead = fastReadSupported();
+        if (!fastRead)
+            issue_waring("EnableFastRead", "rdpmc is not available, the counters are started and stopped as before");
+        generation++;
+        return fastRead;
     }
 
-    /* Print the results */
-    const long long *GetValues()
+    /* Get the codes of the counted events */
+    const std::vector<int> &GetEvents() override
     {
-        return values;
+        return events;
     }
 
-    /* Print the results */
-    void Print() override
+    /* Get the nanoseconds the counters were running, summed up over all threads */
+    long long GetEnabledTime() override
     {
-        if (running)
-            handle_error("Print", "You can not print while Papi is running. Stop the counters first!");
+        long long total = 0;
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            total += completed(state, [state]() { return state->enabledTime; });
+        return total;
+    }
 
-        std::cout << "PAPIW Single PapiWrapper instance report:" << std::endl;
-        print(events, values);
+    /* Get the wall clock nanoseconds the counters were running, i.e. the longest time of all threads */
+    long long GetRealTime() override
+    {
+        long long longest = 0;
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            longest = std::max(longest, completed(state, [state]() { return state->enabledTime; }));
+        return longest;
     }
 
-protected:
-    /* Initialize the values array */
-    void localInit() override
+    /* Get the cpu nanoseconds of all threads while the counters were running */
+    long long GetVirtTime() override
     {
-        for (int i = 0; i < papiMaxAllowedCounters; i++)
-            values[i] = 0;
+        long long total = 0;
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            total += completed(state, [state]() { return state->virtTime; });
+        return total;
     }
-};
 
-#ifdef _OPENMP
-/**
- * PapiWrapper class for Parallel use
- * 
- * It is discoureaged to use this class directly but rather through the utility functions
- * inside the PAPIW namespace.
- */
-class PapiWrapperParallel : public PapiWrapper
-{
-private:
-    inline static PapiWrapperSingle *localPapi;
-#pragma omp threadprivate(localPapi)
-    std::vector<int> events;
-    std::vector<long long> values;
-    int numRunningThreads = 0; //0 is none running
-    bool startedFromParallelRegion = false;
+    /* Get the value of a specific event for every thread which ever counted, in the order they started first */
+    std::vector<long long> GetThreadResults(const int eventCode) override
+    {
+        std::vector<long long> results;
+        appendThreadResults(eventCode, results);
+        return results;
+    }
 
-public:
-    PapiWrapperParallel() {}
-    ~PapiWrapperParallel()
+    /* Print the values of the completed intervals */
+    void Print() override
     {
-        std::cout << "Destructing Local Papis" << std::endl;
-        checkNotInParallelRegion("DESTRUCTOR");
-#pragma omp parallel
+        if (printText)
         {
-            delete localPapi;
-            localPapi = nullptr;
+            std::vector<long long> totals(events.size());
+            GetResults(totals.data());
+
+            std::cout << "PAPIW Threads PapiWrapper instance report:" << std::endl;
+            print(events, totals.data());
+            printOverhead(events);
+            printMetrics(totals.data());
+            if (multiplexed)
+                printMultiplexed(events, GetEnabledTime());
         }
+        exportOnPrint();
     }
 
-    /* Register events to be counted */
-    void AddEvent(const int eventCode) override
+    /* Print the values of every thread */
+    void PrintThreads() override
     {
-        checkNotInParallelRegion("ADD_EVENT");
-        checkNoneRunning("ADD_EVENT");
-        events.push_back(eventCode);
-        values.push_back(0);
+        std::cout << "PAPIW Threads PapiWrapper thread report:" << std::endl;
+        printThreads(events);
     }
 
-    /* Start the counters */
-    void Start() override
+    /* Reset the values of all threads */
+    void Reset() override
     {
-        if (isInParallelRegion())
-        {
-
-#pragma omp single
-            checkNoneRunning("START");
-
-            startedFromParallelRegion = true;
-            start();
-        }
-        else
+        checkNoneRunning("RESET");
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
         {
-            checkNoneRunning("START");
-            startedFromParallelRegion = false;
-#pragma omp parallel
-            {
-                start();
-            }
+            std::fill(state->values.begin(), state->values.end(), 0);
+            state->enabledTime = 0;
+            state->virtTime = 0;
+            state->intervals = 0;
+            if (state->regions != nullptr)
+                state->regions->Reset();
+            if (state->samples != nullptr)
+                state->samples->Reset();
         }
     }
 
-    /* Stop the counters */
-    void Stop() override
+    /* Start measuring a named region on the calling thread, starting its counters if necessary */
+    void BeginRegion(const PAPIW::RegionName &name) override
     {
-        checkNumberOfThreads("STOP");
+        auto state = localState();
+        if (state->regions == nullptr)
+            state->regions = new PapiWrapperRegions(events.size());
+
+        bool owner = !state->running.load(std::memory_order_relaxed);
+        if (owner)
+            start(state, false);
+
+        long long *snapshot = state->regions->Enter(name, owner);
+        if (snapshot == nullptr)
+            handle_error("BeginRegion", "Too many regions. Check PAPIW_MAX_REGIONS and PAPIW_MAX_REGION_DEPTH");
+        PapiWrapperEnergy::Begin(name.hash, name.name);
+        state->papi->Read(snapshot);
+    }
 
-        if (isInParallelRegion())
-        {
-            if (!startedFromParallelRegion)
-                issue_waring("Stop", "The Papi Counters have not been started in a parallel Region. You should not stop them in a parallel region, however, the results should be fine.");
-            stop();
+    /* Stop measuring the innermost named region of the calling thread, stopping its counters if they were started by it */
+    void EndRegion(const PAPIW::RegionName &name) override
+    {
+        auto state = localState();
+        auto regions = state->regions;
+        if (regions == nullptr || regions->Depth() == 0 || !state->running.load(std::memory_order_relaxed))
+            handle_error("EndRegion", "There is no region to end");
+
+        bool owner = regions->IsOwner();
+        long long *current = regions->Scratch();
+        state->papi->Read(current);
+        PapiWrapperTrace::Append(name.hash, name.name, current, events.size(), regions->Snapshot());
+        PapiWrapperDistribution::Record(name.hash, name.name, current, events.size(), regions->Snapshot());
+        if (!regions->Leave(name, current))
+            handle_error("EndRegion", "Regions have to be ended in the reverse order they were begun");
+        PapiWrapperEnergy::End(name.hash);
+
+        if (!owner)
+            return;
+
+        state->papi->StopCounters();
+        state->running.store(false, std::memory_order_release);
+    }
 
-#pragma omp barrier
+    /* Get the result of a specific event inside a named region summed up over all threads */
+    long long GetRegionResult(const PAPIW::RegionName &name, const int eventCode) override
+    {
+        checkNoneRunning("GET_REGION_RESULT");
+        PapiWrapperRegions merged(events.size());
+        mergeRegions(merged);
+        return getRegionResult(events, merged, name, eventCode);
+    }
 
-            numRunningThreads = 0;
-        }
-        else
-        {
-            if (startedFromParallelRegion)
-                issue_waring("Stop", "The Papi Counters have been started in a parallel Region. You should stop them in the same parallel region or move Start/Stop completely out of the parallel region.");
-#pragma omp parallel
-            {
-                stop();
-            }
-            numRunningThreads = 0;
-        }
+    /* Print the values of all named regions summed up over all threads */
+    void PrintRegions() override
+    {
+        checkNoneRunning("PRINT_REGIONS");
+        PapiWrapperRegions merged(events.size());
+        mergeRegions(merged);
+        std::cout << "PAPIW Threads PapiWrapper region report:" << std::endl;
+        printRegions(events, merged);
     }
 
-    /* Get the result of a specific event */
-    long long GetResult(const int eventCode) override
+    /* Print the call tree of nested regions. The trees of all threads are merged by call path */
+    void PrintCallTree() override
     {
-        checkNoneRunning("GET_RESULT");
+        checkNoneRunning("PRINT_CALL_TREE");
+        PapiWrapperRegions merged(events.size());
+        mergeRegions(merged);
+        std::cout << "PAPIW Threads PapiWrapper call tree report:" << std::endl;
+        printCallTree(events, merged.CallTree());
+    }
 
-        auto indexInResult = std::find(events.begin(), events.end(), eventCode);
-        if (indexInResult == events.end())
-            handle_error("GetResult", "The event is not supported or has not been added to the set");
+    /**
+     * Record the instruction pointer whenever an event occurred threshold times on a thread
+     *
+     * @warning Event sets of threads which already counted are rebuilt on their next Start
+     */
+    void EnableSampling(const int eventCode, const int threshold) override
+    {
+        checkNoneRunning("ENABLE_SAMPLING");
+        if (multiplexed)
+            handle_error("EnableSampling", "Sampling is not supported for multiplexed events");
+        if (fastRead)
+            handle_error("EnableSampling", "Sampling is not supported in the fast read mode");
+        if (std::find(events.begin(), events.end(), eventCode) == events.end())
+            handle_error("EnableSampling", "The event is not supported or has not been added to the set");
+
+        sampledEvents.push_back({eventCode, threshold});
+        generation++;
+    }
 
-        return values[indexInResult - events.begin()];
+    /* Print the functions and addresses with the most samples over all threads */
+    void PrintSamples() override
+    {
+        checkNoneRunning("PRINT_SAMPLES");
+        PapiWrapperSamples *merged = new PapiWrapperSamples();
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            if (state->samples != nullptr)
+                merged->Add(*state->samples);
+
+        std::cout << "PAPIW Threads PapiWrapper sample report:" << std::endl;
+        printSamples(*merged);
+        delete merged;
     }
 
-    /* Print the values */
-    void Print() override
+protected:
+    /* The list holds the newest thread first, so the appended values are reversed */
+    void appendThreadResults(const int eventCode, std::vector<long long> &results) override
     {
-        checkNoneRunning("PRINT");
-#pragma omp single
-        {
-            std::cout << "PAPIW Parallel PapiWrapper instance report:" << std::endl;
-            print(events, values.data());
-        }
+        int index = getIndex(eventCode);
+        size_t first = results.size();
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            results.push_back(threadResult(state, index));
+        std::reverse(results.begin() + first, results.end());
     }
 
-    /* Reset the values */
-    void Reset()
+    /* Sum up the named regions of all threads. Exports leave them out while threads are counting */
+    const PapiWrapperRegions *getRegions() override
     {
-        checkNoneRunning("RESET");
-#pragma omp single
-        std::fill(values.begin(), values.end(), 0);
+        if (anyRunning())
+            return nullptr;
+        if (mergedRegions == nullptr)
+            mergedRegions = new PapiWrapperRegions(events.size());
+        mergedRegions->Reset();
+        mergeRegions(*mergedRegions);
+        return mergedRegions;
     }
 
-protected:
     /* Initialize the instance */
     void localInit() override
     {
-        checkNotInParallelRegion("INIT");
-
-        retval = PAPI_thread_init(pthread_self);
+        retval = PapiWrapperBackend::Get().ThreadInit();
         if (retval != PAPI_OK)
-            handle_error("localInit in PapiWrapperParallel", "Could not initialize OMP Support", retval);
-        else
-            std::cout << "Papi Parallel support enabled" << std::endl;
+            handle_error("localInit in PapiWrapperThreads", "Could not initialize thread support", retval);
     }
 
-    /* Helper function to start the counters */
-    void start()
+private:
+    /* Get the state of the calling thread and publish a new one on its first use */
+    ThreadState *localState()
     {
-#pragma omp single
-        numRunningThreads = omp_get_num_threads();
-
-        retval = PAPI_register_thread();
-        if (retval != PAPI_OK)
-            handle_error("Start", "Couldn't register thread", retval);
-
-        localPapi = new PapiWrapperSingle(pthread_self());
-        for (auto eventCode : events)
-            localPapi->AddEvent(eventCode);
-
-        localPapi->Start();
+        for (auto &entry : registry.states)
+            if (entry.first == id)
+                return entry.second;
+
+        prune();
+        auto state = new ThreadState();
+        state->values.resize(events.size(), 0);
+        state->next = states.load(std::memory_order_relaxed);
+        while (!states.compare_exchange_weak(state->next, state, std::memory_order_release, std::memory_order_relaxed))
+            ;
+        registry.states.push_back({id, state});
+        return state;
     }
 
-    /* Helper function to stop the counters and accumulate the values to total */
-    void stop()
+    /* Release the states of the calling thread whose instances are gone, s.t. the registry only holds live instances */
+    static void prune()
     {
-        localPapi->Stop();
+        auto &states = registry.states;
+        auto gone = std::remove_if(states.begin(), states.end(), [](const std::pair<unsigned long, ThreadState *> &entry) {
+            auto state = entry.second;
+            if (state->references.load(std::memory_order_acquire) != 1)
+                return false;
+            delete state->papi;
+            state->papi = nullptr;
+            state->Release();
+            return true;
+        });
+        states.erase(gone, states.end());
+    }
 
-        /*Check that same thread is used since starting the counters*/
-        if (PAPI_thread_id() != localPapi->ThreadID)
-            handle_error("Stop", "Invalid State: The Thread Ids differs from initialization!\nApparently, new threads were use without reassigning the Papi counters. Please Start and Stop more often to avoid this error.");
+    /**
+     * Start the counters of a thread and rebuild its event set if the configuration changed
+     *
+     * @param interval If false, the counters are started for a region and their values are not added to the results
+     */
+    void start(ThreadState *state, const bool interval = true)
+    {
+        if (state->generation != generation)
+            build(state);
+        state->running.store(true, std::memory_order_relaxed);
+        if (interval)
+            state->papi->Start();
+        else
+            state->papi->StartCounters();
+    }
 
-        int eventCount = events.size();
-        for (int i = 0; i < eventCount; i++)
+    /* Build the event set of the calling thread, registering the thread at Papi on first use */
+    void build(ThreadState *state)
+    {
+        if (!registry.registered)
         {
-            auto localVal = localPapi->GetResult(events[i]);
-#pragma omp atomic
-            values[i] += localVal;
+            retval = PapiWrapperBackend::Get().RegisterThread();
+            if (retval != PAPI_OK)
+                handle_error("Start", "Couldn't register thread", retval);
+            registry.registered = true;
         }
 
-        delete localPapi;
-        localPapi = nullptr;
+        delete state->papi;
+        state->papi = new PapiWrapperSingle(pthread_self(), multiplexed);
+        for (auto eventCode : events)
+            state->papi->AddEvent(eventCode);
+        if (fastRead)
+            state->papi->EnableFastRead();
 
-        retval = PAPI_unregister_thread();
-        if (retval != PAPI_OK)
-            handle_error("Stop", "Couldn't unregister thread", retval);
+        if (!sampledEvents.empty())
+        {
+            if (state->samples == nullptr)
+                state->samples = new PapiWrapperSamples();
+            for (auto &sampled : sampledEvents)
+                state->papi->SampleInto(sampled.first, sampled.second, state->samples);
+        }
+        state->events = events;
+        state->generation = generation;
     }
 
-    /* Returns the current OMP team size */
-    int GetNumThreads()
+    /* Sum up the named regions of all threads */
+    void mergeRegions(PapiWrapperRegions &merged)
     {
-        if (isInParallelRegion())
-            return omp_get_num_threads();
+        bool complete = true;
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            if (state->regions != nullptr)
+                complete = merged.Add(*state->regions) && complete;
+        if (!complete)
+            issue_waring("Print", "The threads use too many distinct regions, some are skipped. Check PAPIW_MAX_REGIONS");
+    }
 
-        int count;
-#pragma omp parallel
-        {
-#pragma omp master
-            count = omp_get_num_threads();
-        }
-        return count;
+    /* Value of an event of a thread, corrected by the calibrated overhead if enabled */
+    long long threadResult(const ThreadState *state, const int index)
+    {
+        if (!correctOverhead || overhead.empty())
+            return completed(state, [state, index]() { return state->values[index]; });
+        return completed(state, [this, state, index]() { return std::max(0LL, state->values[index] - overhead[index] * state->intervals); });
     }
 
-    /* Returns true if it is called in a parallel region or false otherwise */
-    bool isInParallelRegion()
+    /* Get a value of the completed intervals of a thread, which may be stopping its counters concurrently */
+    template <typename Value>
+    static long long completed(const ThreadState *state, Value value)
     {
-        return omp_get_level() != 0;
+        long long result;
+        state->ReadCompleted([&result, &value]() { result = value(); });
+        return result;
     }
 
-    /* Check that the current thread team size is not larger then it was last registered or exit with an error otherwise */
-    void checkNumberOfThreads(const char *actionMsg)
+    /* Get the position of an event or exit with an error if it has not been added */
+    int getIndex(const int eventCode)
     {
-        /* State check */
-        if (GetNumThreads() != numRunningThreads)
-            handle_error(actionMsg, "The OMP teamsize is different than indicated in Start!");
+        auto indexInResult = std::find(events.begin(), events.end(), eventCode);
+        if (indexInResult == events.end())
+            handle_error("GetResult", "The event is not supported or has not been added to the set");
+
+        return indexInResult - events.begin();
     }
 
-    /* Check that this method is not called from a parallel context or exit with an error otherwise */
-    void checkNotInParallelRegion(const char *actionMsg)
+    /* True if any thread is counting */
+    bool anyRunning()
     {
-        if (isInParallelRegion())
-            handle_error(actionMsg, "You may not perform this operation from a parallel region");
+        for (auto state = states.load(std::memory_order_acquire); state != nullptr; state = state->next)
+            if (state->running.load(std::memory_order_acquire))
+                return true;
+        return false;
     }
 
-    /* Check that no Papi Counter is running or exit with an error otherwise */
+    /* Check that no thread is counting or exit with an error otherwise */
     void checkNoneRunning(const char *actionMsg)
     {
-        if (numRunningThreads)
-            handle_error(actionMsg, "You can not perform this action while Papi is running. Stop the counters first!");
+        if (anyRunning())
+            handle_error(actionMsg, "You can not perform this action while Papi is running. Stop the counters of all threads first!");
     }
 };
-#endif
 
 #endif
-#endif
\ No newline at end of file
+#endif
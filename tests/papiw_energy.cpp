@@ -0,0 +1,184 @@
+#include "../include/papiwrapper.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * Regression tests of the energy measurement on a fake powercap tree, which needs no RAPL
+ *
+ * Usage: papiw_energy <zones|environment|wraparound|unknown_range>
+ *
+ * Every test builds a temporary tree with the zone intel-rapl:0 and its subzones intel-rapl:0:0 (core) and
+ * intel-rapl:0:1 (dram), and writes the energy_uj files between START and STOP. Returns 0 if all checks pass.
+ */
+
+static PapiWrapperSimulatedBackend simulated;
+static int failures = 0;
+static std::string root;
+
+void check(const char *what, const double actual, const double expected)
+{
+    if (fabs(actual - expected) < 1e-9)
+        return;
+    fprintf(stderr, "FAILED %s: %f instead of %f\n", what, actual, expected);
+    failures++;
+}
+
+void writeFile(const std::string &path, const long long value)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        perror(path.c_str());
+        exit(1);
+    }
+    fprintf(file, "%lld\n", value);
+    fclose(file);
+}
+
+void writeName(const std::string &path, const char *name)
+{
+    FILE *file = fopen((path + "/name").c_str(), "w");
+    if (file == nullptr)
+    {
+        perror(path.c_str());
+        exit(1);
+    }
+    fprintf(file, "%s\n", name);
+    fclose(file);
+}
+
+/* Create a zone with its name, its energy and a range, which is left out if 0 */
+void addZone(const std::string &path, const char *name, const long long energy, const long long range)
+{
+    mkdir(path.c_str(), 0700);
+    writeName(path, name);
+    writeFile(path + "/energy_uj", energy);
+    if (range != 0)
+        writeFile(path + "/max_energy_range_uj", range);
+}
+
+/* Build the tree in a temporary directory. The ranges of all zones are 0 for unknown */
+void buildTree(const long long range)
+{
+    char path[] = "/tmp/papiw_energy_XXXXXX";
+    if (mkdtemp(path) == nullptr)
+    {
+        perror("mkdtemp");
+        exit(1);
+    }
+    root = path;
+    addZone(root + "/intel-rapl:0", "package-0", 1000, range);
+    addZone(root + "/intel-rapl:0/intel-rapl:0:0", "core", 2000, range);
+    addZone(root + "/intel-rapl:0/intel-rapl:0:1", "dram", 3000, range);
+}
+
+void removeTree()
+{
+    std::string command = "rm -rf " + root;
+    if (system(command.c_str()) != 0)
+        fprintf(stderr, "Could not remove %s\n", root.c_str());
+}
+
+/* Count one interval in which the zones advance to the given values */
+void interval(const long long package, const long long core, const long long dram)
+{
+    PAPIW::START();
+    writeFile(root + "/intel-rapl:0/energy_uj", package);
+    writeFile(root + "/intel-rapl:0/intel-rapl:0:0/energy_uj", core);
+    writeFile(root + "/intel-rapl:0/intel-rapl:0:1/energy_uj", dram);
+    PAPIW::STOP();
+}
+
+/* Every zone and subzone is found and measured on its own */
+void zones()
+{
+    buildTree(0);
+    PAPIW::INIT_SINGLE(PAPI_TOT_INS);
+    PAPIW::ENABLE_ENERGY(root.c_str());
+
+    auto names = PAPIW::GET_ENERGY_ZONES();
+    if (names != std::vector<std::string>{"package-0", "package-0/core", "package-0/dram"})
+    {
+        fprintf(stderr, "FAILED zones: Unexpected zone names\n");
+        failures++;
+        return;
+    }
+
+    interval(1500000, 2250000, 3100000);
+    interval(2500000, 2750000, 3200000);
+    auto joules = PAPIW::GET_ENERGY();
+    check("zones package-0", joules[0], 2.499);
+    check("zones package-0/core", joules[1], 2.748);
+    check("zones package-0/dram", joules[2], 3.197);
+}
+
+/* The root can be given in the environment */
+void environment()
+{
+    buildTree(0);
+    setenv("PAPIW_ENERGY_ROOT", root.c_str(), 1);
+    PAPIW::INIT_SINGLE(PAPI_TOT_INS);
+    PAPIW::ENABLE_ENERGY();
+
+    interval(1001000, 2002000, 3003000);
+    auto joules = PAPIW::GET_ENERGY();
+    check("environment zones", PAPIW::GET_ENERGY_ZONES().size(), 3);
+    check("environment package-0", joules.size() == 3 ? joules[0] : 0, 1.0);
+}
+
+/* A smaller value than before is one wraparound at max_energy_range_uj */
+void wraparound()
+{
+    buildTree(1000000);
+    PAPIW::INIT_SINGLE(PAPI_TOT_INS);
+    PAPIW::ENABLE_ENERGY(root.c_str());
+
+    interval(900000, 2000, 3000);
+    interval(100000, 2000, 3000);
+    auto joules = PAPIW::GET_ENERGY();
+    check("wraparound package-0", joules[0], (900000 - 1000 + 100000 + 1000000 - 900000) * 1e-6);
+    check("wraparound package-0/core", joules[1], 0);
+}
+
+/* Without a known range, the interval of a wraparound is skipped instead of counted negative */
+void unknownRange()
+{
+    buildTree(0);
+    PAPIW::INIT_SINGLE(PAPI_TOT_INS);
+    PAPIW::ENABLE_ENERGY(root.c_str());
+
+    interval(900000, 2000, 3000);
+    interval(100000, 2000, 3000);
+    interval(300000, 2000, 3000);
+    auto joules = PAPIW::GET_ENERGY();
+    check("unknown_range package-0", joules[0], (900000 - 1000 + 300000 - 100000) * 1e-6);
+}
+
+int main(int argc, char **argv)
+{
+    PAPIW::SET_BACKEND(&simulated);
+
+    std::string test = argc == 2 ? argv[1] : "";
+    if (test == "zones")
+        zones();
+    else if (test == "environment")
+        environment();
+    else if (test == "wraparound")
+        wraparound();
+    else if (test == "unknown_range")
+        unknownRange();
+    else
+    {
+        std::cerr << "Usage: papiw_energy <zones|environment|wraparound|unknown_range>" << std::endl;
+        return 1;
+    }
+    removeTree();
+    return failures == 0 ? 0 : 1;
+}
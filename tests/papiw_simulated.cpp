@@ -0,0 +1,149 @@
+#include "../include/papiwrapper.h"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <omp.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Regression tests on the simulated backend, which need no hardware counters
+ *
+ * Usage: papiw_simulated <single|parallel|threads|recycle|fail_add|fail_start>
+ *
+ * Every event advances by a scripted delta whenever a running event set is stopped, s.t. the expected
+ * results are known exactly. Returns 0 if all checks pass. fail_start ends with the error of PAPIW instead.
+ */
+
+static PapiWrapperSimulatedBackend simulated;
+static int failures = 0;
+
+void check(const char *what, const long long actual, const long long expected)
+{
+    if (actual == expected)
+        return;
+    fprintf(stderr, "FAILED %s: %lld instead of %lld\n", what, actual, expected);
+    failures++;
+}
+
+/* Intervals of the calling thread add up */
+void single()
+{
+    PAPIW::INIT_SINGLE(PAPI_TOT_INS, PAPI_TOT_CYC);
+    for (int i = 0; i < 10; i++)
+    {
+        PAPIW::START();
+        PAPIW::STOP();
+    }
+    check("single PAPI_TOT_INS", PAPIW::GET_RESULT(PAPI_TOT_INS), 10 * 100);
+    check("single PAPI_TOT_CYC", PAPIW::GET_RESULT(PAPI_TOT_CYC), 10 * 300);
+}
+
+/* Every thread of the team counts, inside and outside of parallel regions */
+void parallel()
+{
+    omp_set_num_threads(4);
+    PAPIW::INIT_PARALLEL(PAPI_TOT_INS);
+    for (int i = 0; i < 3; i++)
+    {
+#pragma omp parallel
+        {
+            PAPIW::START();
+            PAPIW::STOP();
+        }
+    }
+    PAPIW::START();
+    PAPIW::STOP();
+    check("parallel PAPI_TOT_INS", PAPIW::GET_RESULT(PAPI_TOT_INS), 4 * 4 * 100);
+}
+
+/* Threads outside of OpenMP count on their own, also while other threads are still counting */
+void threads()
+{
+    PAPIW::INIT_THREADS(PAPI_TOT_INS);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++)
+        workers.emplace_back([]() {
+            for (int i = 0; i < 5; i++)
+            {
+                PAPIW::START();
+                PAPIW::STOP();
+            }
+        });
+    for (auto &worker : workers)
+        worker.join();
+
+    PAPIW::START();
+    check("threads PAPI_TOT_INS while running", PAPIW::GET_RESULT(PAPI_TOT_INS), 4 * 5 * 100);
+    PAPIW::STOP();
+    check("threads PAPI_TOT_INS", PAPIW::GET_RESULT(PAPI_TOT_INS), (4 * 5 + 1) * 100);
+}
+
+/* Non-persistent teams create an event set per thread and Start, more than the backend holds at the same time */
+void recycle()
+{
+    omp_set_num_threads(4);
+    PAPIW::INIT_PARALLEL(PAPI_TOT_INS);
+    int rounds = PAPIW_SIMULATED_EVENT_SETS / 4 + 100;
+    for (int i = 0; i < rounds; i++)
+    {
+#pragma omp parallel
+        {
+            PAPIW::START();
+            PAPIW::STOP();
+        }
+    }
+    check("recycle PAPI_TOT_INS", PAPIW::GET_RESULT(PAPI_TOT_INS), rounds * 4 * 100LL);
+}
+
+/* An event which can not be added is skipped, the others are counted */
+void failAdd()
+{
+    simulated.FailAt(PapiWrapperSimulatedBackend::Call::AddEvent, simulated.GetCalls(PapiWrapperSimulatedBackend::Call::AddEvent) + 2, PAPI_ECNFLCT);
+    PAPIW::INIT_SINGLE(PAPI_TOT_INS, PAPI_TOT_CYC);
+    PAPIW::START();
+    PAPIW::STOP();
+    check("fail_add PAPI_TOT_CYC counted", PAPIW::IS_COUNTED(PAPI_TOT_CYC), false);
+    check("fail_add PAPI_TOT_INS", PAPIW::GET_RESULT(PAPI_TOT_INS), 100);
+}
+
+/* A Start which fails ends the program with the error of Papi */
+void failStart()
+{
+    PAPIW::INIT_SINGLE(PAPI_TOT_INS);
+    simulated.FailAt(PapiWrapperSimulatedBackend::Call::Start, simulated.GetCalls(PapiWrapperSimulatedBackend::Call::Start) + 2, PAPI_ECNFLCT);
+    PAPIW::START();
+    PAPIW::STOP();
+    PAPIW::START();
+    fprintf(stderr, "FAILED fail_start: The second Start did not fail\n");
+    failures++;
+}
+
+int main(int argc, char **argv)
+{
+    simulated.Script(PAPI_TOT_INS, {100});
+    simulated.Script(PAPI_TOT_CYC, {200, 400});
+    PAPIW::SET_BACKEND(&simulated);
+
+    std::string test = argc == 2 ? argv[1] : "";
+    if (test == "single")
+        single();
+    else if (test == "parallel")
+        parallel();
+    else if (test == "threads")
+        threads();
+    else if (test == "recycle")
+        recycle();
+    else if (test == "fail_add")
+        failAdd();
+    else if (test == "fail_start")
+        failStart();
+    else
+    {
+        std::cerr << "Usage: papiw_simulated <single|parallel|threads|recycle|fail_add|fail_start>" << std::endl;
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,259 @@
+#include "../include/papiwrapper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Benchmark of the overhead of PAPIW itself
+ *
+ * Measures the latency and throughput of START/STOP, named regions, RESET and GET_RESULT for
+ * every mode, thread count, number of events and region length. Built with NOPAPIW, it shows
+ * the cost of disabled instrumentation, which should be the same as the baseline.
+ *
+ * Usage: papiw_bench [--iterations <n>] [--threads <n>] [--simulated]
+ *
+ * With --simulated, the counters come from the deterministic simulated backend, s.t. the overhead of
+ * the threading, aggregation and reporting paths can be measured on machines without hardware counters.
+ * Without hardware counters, the benchmark falls back to the simulated backend on its own.
+ *
+ * The parallel modes run with powers of two threads up to --threads, by default the number of omp threads.
+ * RESET and GET_RESULT are called by the master thread, but their cost grows with the team of the row,
+ * whose threads all counted before.
+ *
+ * Every result is printed as readable line and as machine readable line:
+ *     @%% MODE THREADS EVENTS OPERATION WORK SAMPLES P50_NS P90_NS P99_NS MAX_NS OPS_PER_S
+ *     @%B <values>
+ * WORK is the number of loop iterations inside the measured region. The operation baseline runs
+ * the same loop without instrumentation, s.t. the overhead is the difference to it.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static const int workLengths[] = {0, 100, 10000};
+static const int eventCounts[] = {1, 2, 4};
+
+struct Result
+{
+    std::string mode;
+    int threads;
+    int events;
+    const char *operation;
+    int work;
+    std::vector<long long> latencies; // Nanoseconds of every operation
+    double seconds;                   // Wall clock time of all operations
+};
+
+/* Loop of dependent additions, which the compiler can not remove */
+void work(const int length)
+{
+    volatile long long sum = 0;
+    for (int i = 0; i < length; i++)
+        sum = sum + i;
+}
+
+long long elapsed(const Clock::time_point &begin, const Clock::time_point &end)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+}
+
+long long percentile(const std::vector<long long> &sorted, const int percent)
+{
+    return sorted.empty() ? 0 : sorted[(sorted.size() - 1) * percent / 100];
+}
+
+void print(Result &result)
+{
+    auto &latencies = result.latencies;
+    std::sort(latencies.begin(), latencies.end());
+    long long p50 = percentile(latencies, 50), p90 = percentile(latencies, 90), p99 = percentile(latencies, 99);
+    long long max = latencies.empty() ? 0 : latencies.back();
+    double throughput = result.seconds > 0 ? latencies.size() / result.seconds : 0;
+
+    printf("%-10s threads %2d events %d %-10s work %5d: p50 %8lld ns, p90 %8lld ns, p99 %8lld ns, max %8lld ns, %.0f ops/s\n",
+           result.mode.c_str(), result.threads, result.events, result.operation, result.work, p50, p90, p99, max, throughput);
+    printf("@%%B %s %d %d %s %d %zu %lld %lld %lld %lld %.0f\n", result.mode.c_str(), result.threads, result.events,
+           result.operation, result.work, latencies.size(), p50, p90, p99, max, throughput);
+    fflush(stdout);
+}
+
+template <typename... Codes>
+void init(const std::string &mode, Codes const... codes)
+{
+    if (mode == "single")
+        PAPIW::INIT_SINGLE(codes...);
+    else if (mode == "parallel")
+        PAPIW::INIT_PARALLEL(codes...);
+    else
+        PAPIW::INIT_PARALLEL_PERSISTENT(codes...);
+}
+
+void init(const std::string &mode, const int events)
+{
+    if (events == 1)
+        init(mode, PAPI_TOT_INS);
+    else if (events == 2)
+        init(mode, PAPI_TOT_INS, PAPI_TOT_CYC);
+    else
+        init(mode, PAPI_TOT_INS, PAPI_TOT_CYC, PAPI_L1_DCM, PAPI_L2_TCA);
+}
+
+/* Run an operation on every thread of a team and collect the latencies of all threads */
+template <typename Operation>
+Result measure(const std::string &mode, const int threads, const int events, const char *operation, const int length,
+               const int iterations, Operation run)
+{
+    Result result{mode, threads, events, operation, length, {}, 0};
+    std::vector<std::vector<long long>> threadLatencies(threads, std::vector<long long>(iterations));
+
+    auto begin = Clock::now();
+#pragma omp parallel num_threads(threads)
+    {
+        auto &latencies = threadLatencies[omp_get_thread_num()];
+        for (int i = 0; i < iterations; i++)
+        {
+            auto start = Clock::now();
+            run(length);
+            latencies[i] = elapsed(start, Clock::now());
+        }
+    }
+    result.seconds = elapsed(begin, Clock::now()) * 1e-9;
+
+    for (auto &latencies : threadLatencies)
+        result.latencies.insert(result.latencies.end(), latencies.begin(), latencies.end());
+    return result;
+}
+
+/* Run an operation on the calling thread only, e.g. because it may not be called in a parallel region */
+template <typename Operation>
+Result measureSequential(const std::string &mode, const int threads, const int events, const char *operation, const int iterations, Operation run)
+{
+    Result result{mode, threads, events, operation, 0, std::vector<long long>(iterations), 0};
+
+    auto begin = Clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = Clock::now();
+        run();
+        result.latencies[i] = elapsed(start, Clock::now());
+    }
+    result.seconds = elapsed(begin, Clock::now()) * 1e-9;
+    return result;
+}
+
+/* Check if the default backend can count, i.e. if the machine has hardware counters and the user may use them */
+bool countersAvailable()
+{
+#if !defined(NOPAPIW)
+    auto &backend = PapiWrapperBackend::Get();
+    int eventSet = PAPI_NULL;
+    long long value;
+    bool available = backend.LibraryInit() == PAPI_OK && backend.CreateEventSet(&eventSet) == PAPI_OK &&
+                     backend.AddEvent(eventSet, PAPI_TOT_INS) == PAPI_OK && backend.Start(eventSet) == PAPI_OK &&
+                     backend.Stop(eventSet, &value) == PAPI_OK;
+    if (eventSet != PAPI_NULL)
+    {
+        backend.CleanupEventSet(eventSet);
+        backend.DestroyEventSet(&eventSet);
+    }
+    return available;
+#else
+    return true;
+#endif
+}
+
+void benchmark(const std::string &mode, const int threads, const int events, const int iterations)
+{
+    omp_set_num_threads(threads);
+    init(mode, events);
+    static constexpr PAPIW::RegionName region{"bench"};
+
+    for (auto length : workLengths)
+    {
+        auto baseline = measure(mode, threads, events, "baseline", length, iterations, [](int n) { work(n); });
+        print(baseline);
+
+        auto startStop = measure(mode, threads, events, "start_stop", length, iterations, [](int n) {
+            PAPIW::START();
+            work(n);
+            PAPIW::STOP();
+        });
+        print(startStop);
+
+        /* Regions inside running counters only read them */
+        PAPIW::START();
+        auto nested = measure(mode, threads, events, "region", length, iterations, [](int n) {
+            PAPIW::BEGIN_REGION(region);
+            work(n);
+            PAPIW::END_REGION(region);
+        });
+        PAPIW::STOP();
+        print(nested);
+    }
+
+    auto reset = measureSequential(mode, threads, events, "reset", iterations, []() { PAPIW::RESET(); });
+    print(reset);
+
+    volatile long long sink = 0;
+    auto getResult = measureSequential(mode, threads, events, "get_result", iterations,
+                                       [&sink]() { sink = sink + PAPIW::GET_RESULT(PAPI_TOT_INS); });
+    print(getResult);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 1000;
+    int maxThreads = omp_get_max_threads();
+    bool simulated = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            maxThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--simulated") == 0)
+            simulated = true;
+        else
+        {
+            std::cerr << "Usage: papiw_bench [--iterations <n>] [--threads <n>] [--simulated]" << std::endl;
+            return 1;
+        }
+    }
+    if (iterations <= 0 || maxThreads <= 0)
+    {
+        std::cerr << "The number of iterations and threads has to be positive" << std::endl;
+        return 1;
+    }
+
+#if !defined(NOPAPIW)
+    static PapiWrapperSimulatedBackend backend;
+    if (!simulated && !countersAvailable())
+    {
+        std::cerr << "No hardware counters available, falling back to the simulated backend" << std::endl;
+        simulated = true;
+    }
+    if (simulated)
+        PAPIW::SET_BACKEND(&backend);
+#else
+    (void)simulated;
+#endif
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    printf("@%%%% MODE THREADS EVENTS OPERATION WORK SAMPLES P50_NS P90_NS P99_NS MAX_NS OPS_PER_S\n");
+    for (auto events : eventCounts)
+        benchmark("single", 1, events, iterations);
+    for (auto mode : {"parallel", "persistent"})
+        for (auto threads : threadCounts)
+            for (auto events : eventCounts)
+                benchmark(mode, threads, events, iterations);
+}
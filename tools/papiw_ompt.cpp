@@ -0,0 +1,171 @@
+#include "../include/papiwrapperutil.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <dlfcn.h>
+#include <omp-tools.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * OMPT tool which counts every OpenMP parallel region of an unmodified program
+ *
+ * Usage: OMP_TOOL_LIBRARIES=libpapiw_ompt.so <program>
+ *    or: LD_PRELOAD=libpapiw_ompt.so <program>
+ * The OpenMP runtime has to support OMPT, e.g. LLVM libomp.
+ *
+ * Environment:
+ *     PAPIW_OMPT_EVENTS  Comma separated event names, default PAPI_TOT_INS,PAPI_TOT_CYC
+ *     PAPIW_OMPT_OUTPUT  If set, the report is additionally exported as JSON to this file
+ *
+ * Every thread counts its implicit task of a parallel region as named region of a PapiWrapperThreads.
+ * A region is named by the function and offset of its code pointer, e.g. _Z4workv+0x2c, and summed up
+ * over all threads and all its instances. The region and call tree reports are printed at exit.
+ */
+
+namespace
+{
+    PapiWrapperThreads *counters = nullptr;
+    std::map<const void *, PAPIW::RegionName> regions; // Region of every code pointer, the names are never freed
+    std::mutex regionsMutex;
+
+    /* Name a region after the symbol of its code pointer, or after the offset in its object if there is none */
+    const char *regionName(const void *codeptr)
+    {
+        char name[256];
+        Dl_info info;
+        if (codeptr != nullptr && dladdr(codeptr, &info) != 0 && info.dli_sname != nullptr)
+            snprintf(name, sizeof(name), "%s+0x%lx", info.dli_sname,
+                     static_cast<unsigned long>(static_cast<const char *>(codeptr) - static_cast<const char *>(info.dli_saddr)));
+        else if (codeptr != nullptr && dladdr(codeptr, &info) != 0 && info.dli_fname != nullptr)
+        {
+            const char *file = strrchr(info.dli_fname, '/');
+            snprintf(name, sizeof(name), "%s+0x%lx", file == nullptr ? info.dli_fname : file + 1,
+                     static_cast<unsigned long>(static_cast<const char *>(codeptr) - static_cast<const char *>(info.dli_fbase)));
+        }
+        else
+            snprintf(name, sizeof(name), "%p", codeptr);
+        return strdup(name);
+    }
+
+    /* Get the region of a code pointer, creating it on the first instance */
+    const PAPIW::RegionName *regionOf(const void *codeptr)
+    {
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        auto region = regions.find(codeptr);
+        if (region == regions.end())
+            region = regions.emplace(codeptr, PAPIW::RegionName(regionName(codeptr))).first;
+        return &region->second;
+    }
+
+    /* Split the comma separated event names */
+    std::vector<std::string> eventNames(const char *list)
+    {
+        std::vector<std::string> names;
+        std::string name;
+        for (const char *c = list; *c != '\0'; c++)
+        {
+            if (*c != ',')
+                name += *c;
+            else if (!name.empty())
+            {
+                names.push_back(name);
+                name.clear();
+            }
+        }
+        if (!name.empty())
+            names.push_back(name);
+        return names;
+    }
+
+    /* Called by the encountering thread. The region is handed to the implicit tasks through the parallel data */
+    void onParallelBegin(ompt_data_t *, const ompt_frame_t *, ompt_data_t *parallelData, unsigned int, int, const void *codeptr)
+    {
+        parallelData->ptr = const_cast<PAPIW::RegionName *>(regionOf(codeptr));
+    }
+
+    /* Called by the encountering thread once all implicit tasks have ended */
+    void onParallelEnd(ompt_data_t *parallelData, ompt_data_t *, int, const void *)
+    {
+        parallelData->ptr = nullptr;
+    }
+
+    /* End the region of an implicit task, if it was not ended yet */
+    void endTask(ompt_data_t *taskData)
+    {
+        if (taskData == nullptr || taskData->ptr == nullptr)
+            return;
+        counters->EndRegion(*static_cast<PAPIW::RegionName *>(taskData->ptr));
+        taskData->ptr = nullptr;
+    }
+
+    /* Called by every thread of the team. The parallel data is not available at the end, so the task keeps the region */
+    void onImplicitTask(ompt_scope_endpoint_t endpoint, ompt_data_t *parallelData, ompt_data_t *taskData, unsigned int, unsigned int, int flags)
+    {
+        if (flags & ompt_task_initial)
+            return;
+
+        if (endpoint == ompt_scope_begin)
+        {
+            taskData->ptr = parallelData == nullptr ? nullptr : parallelData->ptr;
+            if (taskData->ptr != nullptr)
+                counters->BeginRegion(*static_cast<PAPIW::RegionName *>(taskData->ptr));
+        }
+        else if (endpoint == ompt_scope_end)
+            endTask(taskData);
+    }
+
+    /**
+     * Workers may report the end of their implicit task only when they are woken up for the next region or at exit.
+     * Their counting ends already when they reach the barrier at the end of the parallel region. Older runtimes report
+     * it like the barriers at the end of worksharing loops as ompt_sync_region_barrier_implicit, which is ignored,
+     * s.t. the counting ends with the implicit task there
+     */
+    void onSyncRegion(ompt_sync_region_t kind, ompt_scope_endpoint_t endpoint, ompt_data_t *, ompt_data_t *taskData, const void *)
+    {
+        if (endpoint == ompt_scope_begin && kind == ompt_sync_region_barrier_implicit_parallel)
+            endTask(taskData);
+    }
+
+    int initialize(ompt_function_lookup_t lookup, int, ompt_data_t *)
+    {
+        auto setCallback = reinterpret_cast<ompt_set_callback_t>(lookup("ompt_set_callback"));
+        if (setCallback == nullptr)
+            return 0;
+
+        if (setCallback(ompt_callback_parallel_begin, reinterpret_cast<ompt_callback_t>(&onParallelBegin)) != ompt_set_always ||
+            setCallback(ompt_callback_parallel_end, reinterpret_cast<ompt_callback_t>(&onParallelEnd)) != ompt_set_always ||
+            setCallback(ompt_callback_implicit_task, reinterpret_cast<ompt_callback_t>(&onImplicitTask)) != ompt_set_always)
+        {
+            fprintf(stderr, "PAPI WARNING in papiw_ompt: The OpenMP runtime does not report all parallel regions\n");
+            return 0;
+        }
+        setCallback(ompt_callback_sync_region, reinterpret_cast<ompt_callback_t>(&onSyncRegion));
+
+        const char *events = getenv("PAPIW_OMPT_EVENTS");
+        counters = new PapiWrapperThreads();
+        counters->Init(eventNames(events == nullptr ? "PAPI_TOT_INS,PAPI_TOT_CYC" : events));
+        return 1;
+    }
+
+    void finalize(ompt_data_t *)
+    {
+        counters->PrintRegions();
+        counters->PrintCallTree();
+
+        const char *output = getenv("PAPIW_OMPT_OUTPUT");
+        if (output != nullptr)
+            counters->Export(PapiWrapperExporter::Get(PAPIW::Format::JSON), output);
+
+        /* The counters are not deleted, since the runtime finalizes the tool after the thread_local state of the main thread is gone */
+    }
+} // namespace
+
+extern "C" ompt_start_tool_result_t *ompt_start_tool(unsigned int, const char *)
+{
+    static ompt_start_tool_result_t result = {&initialize, &finalize, ompt_data_none};
+    return &result;
+}
@@ -0,0 +1,147 @@
+#include "../include/papiwrappertrace.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Offline report of a PAPIW binary trace
+ *
+ * Usage: papiw_report [--csv] [--threads] [--records] <trace>
+ *     --csv      Print comma separated values instead of a table
+ *     --threads  One row per region and thread instead of one per region
+ *     --records  Print every record as CSV instead of aggregating them
+ */
+
+struct Aggregate
+{
+    long long intervals = 0;
+    long long migrated = 0; // Intervals in which the thread changed its cpu
+    std::vector<long long> sums;
+};
+
+void usage()
+{
+    std::cerr << "Usage: papiw_report [--csv] [--threads] [--records] <trace>" << std::endl;
+}
+
+void printRecords(PapiWrapperTraceReader &reader)
+{
+    printf("timestamp_ns,thread,region,migrated");
+    for (auto &name : reader.Names())
+        printf(",%s", name.c_str());
+    printf("\n");
+
+    PAPIW::Trace::RecordHeader record;
+    std::vector<long long> values(reader.Codes().size());
+    while (reader.Next(record, values.data()))
+    {
+        printf("%llu,%u,%s,%d", static_cast<unsigned long long>(record.timestamp), record.thread, reader.RegionName(record.region).c_str(),
+               (record.flags & PAPIW::Trace::RecordMigrated) != 0);
+        for (auto value : values)
+            printf(",%lld", value);
+        printf("\n");
+    }
+}
+
+void printAggregates(PapiWrapperTraceReader &reader, const bool csv, const bool threads)
+{
+    /* Stream the records and sum them up per region (and thread) */
+    std::map<std::pair<std::string, uint32_t>, Aggregate> aggregates;
+    PAPIW::Trace::RecordHeader record;
+    std::vector<long long> values(reader.Codes().size());
+    while (reader.Next(record, values.data()))
+    {
+        auto &aggregate = aggregates[{reader.RegionName(record.region), threads ? record.thread : 0}];
+        aggregate.sums.resize(values.size());
+        aggregate.intervals++;
+        if (record.flags & PAPIW::Trace::RecordMigrated)
+            aggregate.migrated++;
+        for (size_t i = 0; i < values.size(); i++)
+            aggregate.sums[i] += values[i];
+    }
+
+    if (csv)
+    {
+        printf(threads ? "region,thread,intervals,migrated" : "region,intervals,migrated");
+        for (auto &name : reader.Names())
+            printf(",%s", name.c_str());
+        printf("\n");
+
+        for (auto &entry : aggregates)
+        {
+            printf("%s", entry.first.first.c_str());
+            if (threads)
+                printf(",%u", entry.first.second);
+            printf(",%lld,%lld", entry.second.intervals, entry.second.migrated);
+            for (auto sum : entry.second.sums)
+                printf(",%lld", sum);
+            printf("\n");
+        }
+        return;
+    }
+
+    printf("%-24s ", "Region");
+    if (threads)
+        printf("%10s ", "Thread");
+    printf("%12s %10s", "Intervals", "Migrated");
+    for (auto &name : reader.Names())
+        printf(" %18s", name.c_str());
+    printf("\n");
+
+    for (auto &entry : aggregates)
+    {
+        printf("%-24s ", entry.first.first.c_str());
+        if (threads)
+            printf("%10u ", entry.first.second);
+        printf("%12lld %10lld", entry.second.intervals, entry.second.migrated);
+        for (auto sum : entry.second.sums)
+            printf(" %18lld", sum);
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool csv = false;
+    bool threads = false;
+    bool records = false;
+    const char *path = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else if (strcmp(argv[i], "--threads") == 0)
+            threads = true;
+        else if (strcmp(argv[i], "--records") == 0)
+            records = true;
+        else if (argv[i][0] != '-' && path == nullptr)
+            path = argv[i];
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (path == nullptr)
+    {
+        usage();
+        return 1;
+    }
+
+    PapiWrapperTraceReader reader;
+    std::string error;
+    if (!reader.Open(path, error))
+    {
+        std::cerr << "papiw_report: " << path << ": " << error << std::endl;
+        return 1;
+    }
+
+    if (records)
+        printRecords(reader);
+    else
+        printAggregates(reader, csv, threads);
+}